@@ -19,6 +19,9 @@
 #pragma once
 
 #include <QFileInfo>
+#include <functional>
+
+class QObject;
 
 class ZDLFileInfo : public QFileInfo {
 public:
@@ -27,6 +30,14 @@ public:
     explicit ZDLFileInfo(const QString &file);
 
     virtual QString GetFileDescription();
+
+    // Description that doesn't block on reading the file. If pending is set,
+    // IdentifyLater can still improve on it.
+    virtual QString GetCachedDescription(bool *pending);
+
+    // Reads what is needed to describe the file off the GUI thread, then
+    // calls done on it, unless context is gone by then
+    virtual void IdentifyLater(QObject *context, std::function<void()> done) const;
 };
 
 class ZDLIwadInfo : public ZDLFileInfo {
@@ -35,7 +46,27 @@ public:
 
     explicit ZDLIwadInfo(const QString &file);
 
+    // Identify followed by GetCachedDescription, may block on a new file
     QString GetFileDescription() override;
+
+    // Reads what identifies the file into the metadata cache: its digest, if
+    // it may be a known release, and its IWADINFO name. This may hash the
+    // whole file but never touches the configuration, so call it off the
+    // GUI thread.
+    void Identify();
+
+    // Description from what is cached about the file and its name, without
+    // reading it. pending is set if Identify could still change it. Reads
+    // the user's tables from the configuration, so call it on the GUI thread.
+    QString GetCachedDescription(bool *pending) override;
+
+    // Runs Identify on the global thread pool
+    void IdentifyLater(QObject *context, std::function<void()> done) const override;
+
+private:
+    bool NeedsDigest();
+
+    QString Describe(const QByteArray &md5, const QString &iwadinfoName);
 };
 
 class ZDLAppInfo : public ZDLFileInfo {
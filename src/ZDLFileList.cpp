@@ -74,13 +74,11 @@ void ZDLFileList::newConfig() {
     LOGDATAO() << "Reading new config" << Qt::endl;
     pList->clear();
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
-    ZDLSection *section = zconf->getSection("zdl.save");
+    const ZDLSection *section = zconf->getSection("zdl.save");
     if (section) {
-        QVector<ZDLLine *> vctr;
-        section->getRegex("^file[0-9]+d?$", vctr);
-        for (ZDLLine *i: vctr) {
-            auto *zList = new ZDLFileListable(pList, 1001, i->getValue());
-            if (i->getVariable().endsWith("d", Qt::CaseInsensitive)) {
+        for (auto &i: section->list("file", {"", "d"})) {
+            auto *zList = new ZDLFileListable(pList, 1001, i.line->getValue());
+            if (i.line->getVariable().endsWith("d", Qt::CaseInsensitive)) {
                 QFont item_font = zList->font();
                 item_font.setStrikeOut(true);
                 zList->setFont(item_font);
@@ -93,16 +91,7 @@ void ZDLFileList::newConfig() {
 void ZDLFileList::rebuild() {
     LOGDATAO() << "Saving config" << Qt::endl;
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
-    ZDLSection *section = zconf->getSection("zdl.save");
-    if (section) {
-        QVector<ZDLLine *> vctr;
-        section->getRegex("^file[0-9]+d?$", vctr);
-        for (auto &i: vctr) {
-            // Can't use the section to perform this operation
-            // Section is a clone of the real section
-            zconf->deleteValue("zdl.save", i->getVariable());
-        }
-    }
+    zconf->deleteRegex("zdl.save", "^file[0-9]+d?$");
 
     //cout << "Building lines" << Qt::endl;
     for (int i = 0; i < count(); i++) {
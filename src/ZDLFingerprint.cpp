@@ -0,0 +1,151 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QCryptographicHash>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <atomic>
+#include <new>
+#include <thread>
+#include "ZDLFingerprint.h"
+#include "ZDLMetaCache.h"
+#include "miniz.h"
+
+namespace {
+    const qint64 hash_buffer_size = 1024 * 1024;
+    const std::align_val_t hash_buffer_alignment{4096};
+
+    std::atomic<bool> stopping(false);
+
+    // Page aligned and large, so that reads stream straight from the page cache
+    class HashBuffer {
+    public:
+        HashBuffer() :
+                data((char *) ::operator new(hash_buffer_size, hash_buffer_alignment)) {
+        }
+
+        ~HashBuffer() {
+            ::operator delete(data, hash_buffer_alignment);
+        }
+
+        HashBuffer(const HashBuffer &) = delete;
+
+        HashBuffer &operator=(const HashBuffer &) = delete;
+
+        char *data;
+    };
+
+    struct BackgroundPool : QThreadPool {
+        BackgroundPool() {
+            setMaxThreadCount(1);
+        }
+    };
+
+    QThreadPool *backgroundPool() {
+        static BackgroundPool pool;
+        return &pool;
+    }
+}
+
+bool ZDLFingerprint::compute(const QString &file, ZDLFingerprint &fingerprint) {
+    QFile hash_file(file);
+    if (!hash_file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    HashBuffer buffers[2];
+    qint64 sizes[2] = {};
+    QSemaphore free_buffers(2);
+    QSemaphore full_buffers(0);
+    std::atomic<bool> done(false);
+
+    //The reader fills one buffer while the other one is being hashed
+    std::thread reader([&]() {
+        for (int i = 0;; i ^= 1) {
+            free_buffers.acquire();
+            sizes[i] = done ? -1 : hash_file.read(buffers[i].data, hash_buffer_size);
+            full_buffers.release();
+
+            if (sizes[i] <= 0) {
+                break;
+            }
+        }
+    });
+
+    QCryptographicHash md5(QCryptographicHash::Md5);
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    mz_ulong crc = MZ_CRC32_INIT;
+    qint64 size;
+
+    for (int i = 0;; i ^= 1) {
+        full_buffers.acquire();
+        size = sizes[i];
+
+        if (size <= 0 || stopping) {
+            //Wake the reader up in case it is waiting for a free buffer
+            done = true;
+            free_buffers.release();
+            break;
+        }
+
+        QByteArray chunk = QByteArray::fromRawData(buffers[i].data, (int) size);
+        md5.addData(chunk);
+        sha1.addData(chunk);
+        crc = mz_crc32(crc, (const uchar *) buffers[i].data, (size_t) size);
+        free_buffers.release();
+    }
+
+    reader.join();
+
+    if (size < 0 || stopping) {
+        return false;
+    }
+
+    fingerprint.md5 = md5.result();
+    fingerprint.sha1 = sha1.result();
+    fingerprint.crc32 = (quint32) crc;
+    return true;
+}
+
+void ZDLFingerprint::schedule(const QString &file) {
+    if (stopping || (ZDLMetaCache::getInstance()->lookup(file).known & ZDLMetaCache::Digests)) {
+        return;
+    }
+
+    backgroundPool()->start([file]() {
+        ZDLMetaCache *cache = ZDLMetaCache::getInstance();
+
+        //The same file may have been queued more than once
+        if (cache->lookup(file).known & ZDLMetaCache::Digests) {
+            return;
+        }
+
+        ZDLMetaCache::Entry entry;
+        if (compute(file, entry.digests)) {
+            entry.known = ZDLMetaCache::Digests;
+            cache->store(file, entry);
+        }
+    });
+}
+
+void ZDLFingerprint::shutdown() {
+    stopping = true;
+    backgroundPool()->clear();
+    backgroundPool()->waitForDone();
+}
@@ -0,0 +1,41 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// MD5, SHA-1 and CRC32 of a file, computed in a single streaming pass. A
+// helper thread reads the next chunk while the current one is hashed.
+struct ZDLFingerprint {
+    QByteArray md5;
+    QByteArray sha1;
+    quint32 crc32 = 0;
+
+    // Returns false if file couldn't be read completely or hashing was
+    // interrupted by shutdown()
+    static bool compute(const QString &file, ZDLFingerprint &fingerprint);
+
+    // Fingerprints file in the background and stores the result in
+    // ZDLMetaCache, unless it is already cached there. One file is hashed
+    // at a time so that scanning doesn't compete with itself for the disk.
+    static void schedule(const QString &file);
+
+    // Drops queued files and stops the one being hashed, call before exit
+    static void shutdown();
+};
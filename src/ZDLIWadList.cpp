@@ -55,33 +55,20 @@ void ZDLIWadList::wizardAddButton() {
 void ZDLIWadList::newConfig() {
     pList->clear();
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
-    ZDLSection *section = zconf->getSection("zdl.iwads");
+    const ZDLSection *section = zconf->getSection("zdl.iwads");
     if (section) {
-        QVector<ZDLLine *> fileVctr;
-        section->getRegex("^i[0-9]+f$", fileVctr);
-
-        for (auto &i: fileVctr) {
-            QString value = i->getVariable();
-
-            QString number = "^i";
-            number.append(value.mid(1, value.length() - 2));
-            number.append("n$");
-
-            QVector<ZDLLine *> nameVctr;
-            section->getRegex(number, nameVctr);
-            if (nameVctr.size() == 1) {
-                QString disName = nameVctr[0]->getValue();
-                QString fileName = i->getValue();
-                auto *zList = new ZDLNameListable(pList, 1001, fileName, disName);
-                insert(zList, -1);
-            }
+        for (auto &i: section->pairs("i", "f", "n")) {
+            QString disName = i.second->getValue();
+            QString fileName = i.first->getValue();
+            auto *zList = new ZDLNameListable(pList, 1001, fileName, disName);
+            insert(zList, -1);
         }
     }
 }
 
 void ZDLIWadList::rebuild() {
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
-    ZDLSection *section = zconf->getSection("zdl.iwads");
+    const ZDLSection *section = zconf->getSection("zdl.iwads");
     if (section) {
         zconf->deleteSection("zdl.iwads");
     }
@@ -99,7 +86,7 @@ void ZDLIWadList::newDrop(const QStringList &fileList) {
     LOGDATAO() << "newDrop" << Qt::endl;
 
     for (const QString &i: fileList)
-        insert(new ZDLNameListable(pList, 1001, i, ZDLIwadInfo(i).GetFileDescription()), -1);
+        insert(newListable(i), -1);
 }
 
 void ZDLIWadList::addButton() {
@@ -109,7 +96,39 @@ void ZDLIWadList::addButton() {
     for (const QString &fileName: fileNames) {
         LOGDATAO() << "Adding file " << fileName << Qt::endl;
         saveWadLastDir(fileName);
-        insert(new ZDLNameListable(pList, 1001, fileName, ZDLIwadInfo(fileName).GetFileDescription()), -1);
+        insert(newListable(fileName), -1);
+    }
+}
+
+ZDLListable *ZDLIWadList::newListable(const QString &file) {
+    bool pending = false;
+    ZDLIwadInfo iwad(file);
+    QString name = iwad.GetCachedDescription(&pending);
+
+    if (pending) {
+        iwad.IdentifyLater(this, [this, file, name]() {
+            identified(file, name);
+        });
+    }
+
+    return new ZDLNameListable(pList, 1001, file, name);
+}
+
+void ZDLIWadList::identified(const QString &file, const QString &provisional) {
+    bool pending;
+    QString name = ZDLIwadInfo(file).GetCachedDescription(&pending);
+
+    if (name == provisional) {
+        return;
+    }
+
+    for (int i = 0; i < count(); i++) {
+        auto *fitm = (ZDLNameListable *) pList->item(i);
+
+        //Leave alone anything the user renamed in the meantime
+        if (fitm->getFile() == file && fitm->getName() == provisional) {
+            fitm->setDisplayName(name);
+        }
     }
 }
 
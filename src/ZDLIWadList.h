@@ -37,6 +37,14 @@ public:
 
     void newDrop(const QStringList &fileList) override;
 
+protected:
+    // Listable for file, named from cached data. Files that still need
+    // reading are identified in the background and renamed once that is done.
+    ZDLListable *newListable(const QString &file);
+
+    // Names file again now that Identify has cached what it found
+    void identified(const QString &file, const QString &provisional);
+
 protected slots:
 
     void wizardAddButton();
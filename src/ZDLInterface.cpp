@@ -226,14 +226,7 @@ void ZDLInterface::clearAllPWads() {
     LOGDATAO() << "Clearing all PWads" << Qt::endl;
     mw->writeConfig();
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
-    ZDLSection *section = zconf->getSection("zdl.save");
-    if (section) {
-        QVector<ZDLLine *> vctr;
-        section->getRegex("^file[0-9]+d?$", vctr);
-        for (auto &i: vctr) {
-            zconf->deleteValue("zdl.save", i->getVariable());
-        }
-    }
+    zconf->deleteRegex("zdl.save", "^file[0-9]+d?$");
     mw->startRead();
 }
 
@@ -271,9 +264,9 @@ void ZDLInterface::launch() {
 
 void ZDLInterface::buttonPaneNewConfig() {
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
-    ZDLSection *section = zconf->getSection("zdl.save");
+    const ZDLSection *section = zconf->getSection("zdl.save");
     if (section) {
-        QVector<ZDLLine *> vctr;
+        QVector<const ZDLLine *> vctr;
         section->getRegex("^dlgmode$", vctr);
         for (auto &i: vctr) {
             if (i->getValue().compare("open", Qt::CaseInsensitive) == 0) {
@@ -377,19 +370,12 @@ void ZDLInterface::loadZdlFile() {
     QString fileName = QFileDialog::getOpenFileName(this, "Load ZDL", getZdlLastDir(), filters);
     if (!fileName.isNull() && !fileName.isEmpty()) {
         ZDLConf *current = ZDLConfigurationManager::getActiveConfiguration();
-        for (int i = 0; i < current->sections.size(); i++) {
-            if (current->sections[i]->getName().compare("zdl.save") == 0) {
-                ZDLSection *section = current->sections[i];
-                current->sections.remove(i);
-                delete section;
-                break;
-            }
-        }
+        current->deleteSectionByName("zdl.save");
         auto *newConf = new ZDLConf();
         newConf->readINI(fileName);
         for (auto &i: newConf->sections) {
             if (i->getName().compare("zdl.save") == 0) {
-                ZDLSection *section = i;
+                const ZDLSection *section = i;
                 current->addSection(section->clone());
                 break;
             }
@@ -503,7 +489,7 @@ void ZDLInterface::newConfig() {
     //Grab our configuration
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
     //Grab our section in the configuration
-    ZDLSection *section = zconf->getSection("zdl.save");
+    const ZDLSection *section = zconf->getSection("zdl.save");
     //Do we have it?
     if (section && !section->findVariable("dlgmode").compare("open", Qt::CaseInsensitive)) {
         if (mpane == nullptr) {
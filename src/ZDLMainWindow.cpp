@@ -291,7 +291,9 @@ QStringList WarpBackwardCompat(const QString &iwad_path, const QString &map_name
     if (iwad_path.length()) {
         bool iwad_mapxx = false;
 
-        if (ZDLMapFile *mapfile = ZDLMapFile::getMapFile(iwad_path)) {
+        ZDLMapFile::DirOptions dir_options =
+                ZDLMapFile::DirOptions::fromConfig(ZDLConfigurationManager::getActiveConfiguration());
+        if (ZDLMapFile *mapfile = ZDLMapFile::getMapFile(iwad_path, dir_options)) {
             iwad_mapxx = mapfile->isMAPXX();
             delete mapfile;
         }
@@ -378,31 +380,18 @@ QString ZDLMainWindow::getArgumentsString(bool native_sep)
     LOGDATAO() << "Getting arguments" << Qt::endl;
     QString args;
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
-    ZDLSection *section = nullptr;
+    const ZDLSection *section = nullptr;
 
     QString iwadName = zconf->getValue("zdl.save", "iwad");
     QString iwadPath;
 
     section = zconf->getSection("zdl.iwads");
     if (section&&iwadName.length()){
-        QVector<ZDLLine*> fileVctr;
-        section->getRegex("^i[0-9]+n$", fileVctr);
-
-        for(int i = 0; i < fileVctr.size(); i++){
-            ZDLLine *line = fileVctr[i];
-            if(line->getValue().compare(iwadName) == 0){
-                QString var = line->getVariable();
-                if(var.length() >= 3){
-                    var = var.mid(1,var.length()-2);
-                    QVector<ZDLLine*> nameVctr;
-                    var = QString("i") + var + QString("f");
-                    section->getRegex("^" + var + "$",nameVctr);
-                    if(nameVctr.size() == 1){
-                        iwadPath=nameVctr[0]->getValue();
-                        args.append("-iwad ");
-                        args.append(QuoteParam(IF_NATIVE_SEP(iwadPath)));
-                    }
-                }
+        for(auto &i: section->pairs("i", "n", "f")){
+            if(i.first->getValue().compare(iwadName) == 0){
+                iwadPath=i.second->getValue();
+                args.append("-iwad ");
+                args.append(QuoteParam(IF_NATIVE_SEP(iwadPath)));
             }
         }
     }
@@ -450,23 +439,22 @@ QString ZDLMainWindow::getArgumentsString(bool native_sep)
     QStringList autoexecs;
     char deh_last=1;
     if (section){
-        QVector<ZDLLine*> fileVctr;
-        section->getRegex("^file[0-9]+$", fileVctr);
+        ZDLSection::IndexedList files = section->list("file");
 
-        if (fileVctr.size() > 0){
-            for(int i = 0; i < fileVctr.size(); i++){
-                if(fileVctr[i]->getValue().endsWith(".bex",Qt::CaseInsensitive)) {
+        if (files.size() > 0){
+            for(auto &file: files){
+                if(file.line->getValue().endsWith(".bex",Qt::CaseInsensitive)) {
                     deh_last=0;
-                    bexs << fileVctr[i]->getValue();
-                } else if(fileVctr[i]->getValue().endsWith(".deh",Qt::CaseInsensitive)) {
+                    bexs << file.line->getValue();
+                } else if(file.line->getValue().endsWith(".deh",Qt::CaseInsensitive)) {
                     deh_last=1;
-                    dehs << fileVctr[i]->getValue();
-                } else if(fileVctr[i]->getValue().endsWith(".cfg",Qt::CaseInsensitive)) {
-                    autoexecs << fileVctr[i]->getValue();
-                } else if(fileVctr[i]->getValue().endsWith(".lmp",Qt::CaseInsensitive)) {
-                    lumps << fileVctr[i]->getValue();
+                    dehs << file.line->getValue();
+                } else if(file.line->getValue().endsWith(".cfg",Qt::CaseInsensitive)) {
+                    autoexecs << file.line->getValue();
+                } else if(file.line->getValue().endsWith(".lmp",Qt::CaseInsensitive)) {
+                    lumps << file.line->getValue();
                 } else {
-                    pwads << fileVctr[i]->getValue();
+                    pwads << file.line->getValue();
                 }
             }
         }
@@ -629,24 +617,12 @@ QStringList ZDLMainWindow::getArgumentsList() {
     QString iwadPath;
     QString iwadName = zconf->getValue("zdl.save", "iwad");
 
-    ZDLSection *section = zconf->getSection("zdl.iwads");
+    const ZDLSection *section = zconf->getSection("zdl.iwads");
     if (section && iwadName.length()) {
-        QVector<ZDLLine *> fileVctr;
-        section->getRegex("^i[0-9]+n$", fileVctr);
-
-        for (auto line: fileVctr) {
-            if (line->getValue().compare(iwadName) == 0) {
-                QString var = line->getVariable();
-                if (var.length() >= 3) {
-                    var = var.mid(1, var.length() - 2);
-                    QVector<ZDLLine *> nameVctr;
-                    var = QString("i") + var + QString("f");
-                    section->getRegex("^" + var + "$", nameVctr);
-                    if (nameVctr.size() == 1) {
-                        iwadPath = nameVctr[0]->getValue();
-                        args << "-iwad" << iwadPath;
-                    }
-                }
+        for (auto &i: section->pairs("i", "n", "f")) {
+            if (i.first->getValue().compare(iwadName) == 0) {
+                iwadPath = i.second->getValue();
+                args << "-iwad" << iwadPath;
             }
         }
     }
@@ -686,23 +662,22 @@ QStringList ZDLMainWindow::getArgumentsList() {
     QStringList lumps;
     char deh_last = 1;
     if (section) {
-        QVector<ZDLLine *> fileVctr;
-        section->getRegex("^file[0-9]+$", fileVctr);
+        ZDLSection::IndexedList files = section->list("file");
 
-        if (!fileVctr.empty()) {
-            for (auto &i: fileVctr) {
-                if (i->getValue().endsWith(".bex", Qt::CaseInsensitive)) {
+        if (!files.empty()) {
+            for (auto &i: files) {
+                if (i.line->getValue().endsWith(".bex", Qt::CaseInsensitive)) {
                     deh_last = 0;
-                    bexs << i->getValue();
-                } else if (i->getValue().endsWith(".deh", Qt::CaseInsensitive)) {
+                    bexs << i.line->getValue();
+                } else if (i.line->getValue().endsWith(".deh", Qt::CaseInsensitive)) {
                     deh_last = 1;
-                    dehs << i->getValue();
-                } else if (i->getValue().endsWith(".cfg", Qt::CaseInsensitive)) {
-                    autoexecs << i->getValue();
-                } else if (i->getValue().endsWith(".lmp", Qt::CaseInsensitive)) {
-                    lumps << i->getValue();
+                    dehs << i.line->getValue();
+                } else if (i.line->getValue().endsWith(".cfg", Qt::CaseInsensitive)) {
+                    autoexecs << i.line->getValue();
+                } else if (i.line->getValue().endsWith(".lmp", Qt::CaseInsensitive)) {
+                    lumps << i.line->getValue();
                 } else {
-                    pwads << i->getValue();
+                    pwads << i.line->getValue();
                 }
             }
         }
@@ -842,24 +817,12 @@ QString ZDLMainWindow::getExecutable() {
     int stat;
     QString portName;
     if (zconf->hasValue("zdl.save", "port")) {
-        ZDLSection *section = zconf->getSection("zdl.ports");
+        const ZDLSection *section = zconf->getSection("zdl.ports");
         portName = zconf->getValue("zdl.save", "port", &stat);
-        QVector<ZDLLine *> fileVctr;
-        section->getRegex("^p[0-9]+n$", fileVctr);
-
-        for (auto line: fileVctr) {
-            if (line->getValue().compare(portName) == 0) {
-                QString var = line->getVariable();
-                if (var.length() >= 3) {
-                    var = var.mid(1, var.length() - 2);
-                    QVector<ZDLLine *> nameVctr;
-                    var = QString("p") + var + QString("f");
-                    section->getRegex("^" + var + "$", nameVctr);
-                    if (nameVctr.size() == 1) {
-                        LOGDATAO() << "Executable: " << nameVctr[0]->getValue() << Qt::endl;
-                        return QString(nameVctr[0]->getValue());
-                    }
-                }
+        for (auto &i: section->pairs("p", "n", "f")) {
+            if (i.first->getValue().compare(portName) == 0) {
+                LOGDATAO() << "Executable: " << i.second->getValue() << Qt::endl;
+                return QString(i.second->getValue());
             }
         }
     }
@@ -0,0 +1,163 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include "ZDLMapCatalog.h"
+
+namespace {
+    //Sorts below any character a map name can contain
+    const QChar number_mark(char16_t(1));
+}
+
+QString ZDLMapCatalog::sortKey(const QString &name) {
+    //Based on "The Alphanum Algorithm" by David Koelle
+    //http://www.davekoelle.com/alphanum.html
+    //Released under MIT License (https://opensource.org/licenses/MIT)
+
+    //Runs of digits become a mark (so that digits sort before letters), the
+    //count of significant digits and then the digits themselves. Comparing
+    //those as strings compares the numbers. At most 9 significant digits go
+    //in one run, which is plenty for WAD map names limited to 8 characters.
+    QString key;
+    key.reserve(name.size() + 4);
+
+    for (auto it = name.begin(); it != name.end();) {
+        if (!it->isDigit()) {
+            key += *it++;
+            continue;
+        }
+
+        QString digits;
+        while (it != name.end() && it->isDigit() && digits.size() < 9) {
+            int value = it->digitValue();
+            if (value || !digits.isEmpty()) {
+                digits += QChar(char16_t('0' + value));
+            }
+            ++it;
+        }
+
+        key += number_mark;
+        key += QChar(char16_t(2 + digits.size()));
+        key += digits;
+    }
+
+    return key;
+}
+
+ZDLMapCatalog::Key ZDLMapCatalog::makeKey(const QString &name) {
+    return {sortKey(name), name};
+}
+
+QStringList ZDLMapCatalog::sorted(std::vector<Key> &keys) {
+    std::sort(keys.begin(), keys.end());
+
+    QStringList list;
+    list.reserve((int) keys.size());
+    for (const Key &key: keys) {
+        list += key.name;
+    }
+
+    return list;
+}
+
+ZDLMapCatalog::Change ZDLMapCatalog::setSource(const QString &source, const QStringList &names) {
+    QStringList unique = names;
+    unique.removeDuplicates();
+
+    //Add first, so that names the old and new lists share never drop out
+    std::vector<Key> added;
+    for (const QString &name: unique) {
+        Key key = makeKey(name);
+        if (++refs[key] == 1) {
+            added.push_back(key);
+        }
+    }
+
+    std::vector<Key> removed;
+    auto it = sourceNames.find(source);
+    if (it != sourceNames.end()) {
+        release(*it, removed);
+    }
+
+    sourceNames.insert(source, unique);
+
+    QStringList added_names = sorted(added);
+    return {added_names, positions(added), sorted(removed)};
+}
+
+ZDLMapCatalog::Change ZDLMapCatalog::removeSource(const QString &source) {
+    auto it = sourceNames.find(source);
+    if (it == sourceNames.end()) {
+        return {};
+    }
+
+    std::vector<Key> removed;
+    release(*it, removed);
+    sourceNames.erase(it);
+    return {{}, {}, sorted(removed)};
+}
+
+void ZDLMapCatalog::release(const QStringList &names, std::vector<Key> &removed) {
+    for (const QString &name: names) {
+        auto it = refs.find(makeKey(name));
+        if (it != refs.end() && --it->second == 0) {
+            removed.push_back(it->first);
+            refs.erase(it);
+        }
+    }
+}
+
+bool ZDLMapCatalog::hasSource(const QString &source) const {
+    return sourceNames.contains(source);
+}
+
+QStringList ZDLMapCatalog::sources() const {
+    return sourceNames.keys();
+}
+
+QVector<int> ZDLMapCatalog::positions(const std::vector<Key> &keys) const {
+    QVector<int> at;
+    at.reserve((int) keys.size());
+
+    //Both are sorted, so this is a merge rather than a lookup per key
+    auto key = keys.begin();
+    int index = 0;
+    for (auto it = refs.begin(); it != refs.end() && key != keys.end(); ++it, ++index) {
+        if (!(it->first < *key)) {
+            at += index;
+            ++key;
+        }
+    }
+
+    return at;
+}
+
+QStringList ZDLMapCatalog::names() const {
+    QStringList list;
+    list.reserve((int) refs.size());
+
+    for (const auto &ref: refs) {
+        list += ref.first.name;
+    }
+
+    return list;
+}
+
+int ZDLMapCatalog::size() const {
+    return (int) refs.size();
+}
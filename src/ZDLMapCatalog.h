@@ -0,0 +1,81 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include <map>
+#include <vector>
+
+// Naturally sorted set of the map names found in a number of sources (the
+// IWAD and each PWAD). A name stays in the catalog for as long as at least
+// one source provides it, so adding or dropping a single source only
+// touches the names that source brings in.
+class ZDLMapCatalog {
+public:
+    // What a source update did to the catalog, in sorted order. addedAt
+    // holds the position each added name ends up at, so inserting them in
+    // order after dropping the removed ones keeps a copy of the list sorted.
+    struct Change {
+        QStringList added;
+        QVector<int> addedAt;
+        QStringList removed;
+    };
+
+    // Replaces the names provided by source
+    Change setSource(const QString &source, const QStringList &names);
+
+    Change removeSource(const QString &source);
+
+    bool hasSource(const QString &source) const;
+
+    QStringList sources() const;
+
+    QStringList names() const;
+
+    int size() const;
+
+    // Key that orders names the way "The Alphanum Algorithm" does, so that
+    // MAP2 sorts before MAP10, when compared as plain strings
+    static QString sortKey(const QString &name);
+
+private:
+    struct Key {
+        QString sortKey;
+        QString name;
+
+        bool operator<(const Key &other) const {
+            int cmp = sortKey.compare(other.sortKey);
+            return cmp < 0 || (cmp == 0 && name < other.name);
+        }
+    };
+
+    static Key makeKey(const QString &name);
+
+    static QStringList sorted(std::vector<Key> &keys);
+
+    // Positions of sorted keys, all of them in the catalog, found in one pass
+    QVector<int> positions(const std::vector<Key> &keys) const;
+
+    // Drops a reference to each of names, collecting those that are gone
+    void release(const QStringList &names, std::vector<Key> &removed);
+
+    std::map<Key, int> refs;
+    QHash<QString, QStringList> sourceNames;
+};
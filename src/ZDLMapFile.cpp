@@ -18,11 +18,19 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QRegularExpression>
+#include <QThreadPool>
 #include "ZDLMapFile.h"
-#include "QRegularExpression"
 #include "libwad.h"
 #include "ZLibPK3.h"
 #include "ZLibDir.h"
+#include "ZLib7z.h"
+#include "zdlcommon.h"
+#include "ZDLMetaCache.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#endif
 
 union magic_t {
     char n[4];
@@ -32,36 +40,117 @@ union magic_t {
 const magic_t iwad_m = {{'I', 'W', 'A', 'D'}};
 const magic_t pwad_m = {{'P', 'W', 'A', 'D'}};
 const magic_t zip_m = {{'P', 'K', 0x03, 0x04}};
+const magic_t sevenzip_m = {{'7', 'z', (char) 0xBC, (char) 0xAF}};
 
 ZDLMapFile::~ZDLMapFile()
 = default;
 
-ZDLMapFile *ZDLMapFile::getMapFile(const QString &file) {
-    ZDLMapFile *mapfile = nullptr;
-    QFileInfo file_info(file);
-    QString ext = file_info.completeSuffix();
-    QRegularExpression ban_exts("lmp|txt|cfg|ini|deh|bex|zdl|zds|dsg|esg");    //Blacklist obvious non-map files
-
-    if (file_info.isDir()) {
-        mapfile = new ZLibDir(file);
-    } else if (ext.length()
-               && !ban_exts.match(ext, Qt::CaseInsensitive).hasMatch()
-               && file_info.exists()) {    //Only process files with present non-blacklisted extension
+namespace {
+    //Probing is I/O bound, more threads than this mostly fight over the disk
+    const int default_probe_concurrency = 4;
+
+    //Map files read their headers right after being probed
+    const qint64 probe_readahead = 64 * 1024;
+
+    ZDLMapFile::Type probeFile(const QString &file) {
+        //Blacklist obvious non-map files
+        static const QRegularExpression ban_exts("lmp|txt|cfg|ini|deh|bex|zdl|zds|dsg|esg",
+                                                 QRegularExpression::CaseInsensitiveOption);
+        QFileInfo file_info(file);
+
+        if (file_info.isDir()) {
+            return ZDLMapFile::Directory;
+        }
+
+        //Only process files with present non-blacklisted extension
+        QString ext = file_info.completeSuffix();
+        if (!ext.length() || ban_exts.match(ext).hasMatch() || !file_info.exists()) {
+            return ZDLMapFile::Unknown;
+        }
+
         QFile fileio(file);
+        magic_t file_m{};
 
-        if (fileio.open(QIODevice::ReadOnly)) {
-            magic_t file_m{};
+        if (!fileio.open(QIODevice::ReadOnly)) {
+            return ZDLMapFile::Unknown;
+        }
+
+#ifdef __linux__
+        posix_fadvise(fileio.handle(), 0, probe_readahead, POSIX_FADV_WILLNEED);
+#endif
 
-            if (fileio.read(file_m.n, 4) == 4) {
-                if (file_m.x == iwad_m.x || file_m.x == pwad_m.x)
-                    mapfile = new DoomWad(file);
-                else if (file_m.x == zip_m.x)
-                    mapfile = new ZLibPK3(file);
-            }
+        if (fileio.read(file_m.n, 4) != 4) {
+            return ZDLMapFile::Unknown;
         }
 
-        fileio.close();
+        if (file_m.x == iwad_m.x || file_m.x == pwad_m.x)
+            return ZDLMapFile::Wad;
+        else if (file_m.x == zip_m.x)
+            return ZDLMapFile::PK3;
+        else if (file_m.x == sevenzip_m.x)
+            return ZDLMapFile::SevenZip;
+
+        return ZDLMapFile::Unknown;
+    }
+}
+
+ZDLMapFile *ZDLMapFile::getMapFile(const QString &file, const DirOptions &dirOptions) {
+    return Probe{file, probeFile(file)}.open(dirOptions);
+}
+
+ZDLMapFile::DirOptions ZDLMapFile::DirOptions::fromConfig(ZDLConf *zconf) {
+    DirOptions options;
+
+    if (zconf) {
+        int stat;
+        options.recursive = zconf->getValue("zdl.general", "dirscanrecursive", &stat) == "1";
+        options.concurrency = zconf->getValue("zdl.general", "dirscanthreads", &stat).toInt();
+    }
+
+    return options;
+}
+
+QVector<ZDLMapFile::Probe> ZDLMapFile::probe(const QStringList &files, int concurrency) {
+    QVector<Probe> probes(files.size());
+
+    if (files.size() == 1) {
+        probes[0] = {files[0], probeFile(files[0])};
+        return probes;
+    }
+
+    Probe *results = probes.data();
+    QThreadPool pool;
+    pool.setMaxThreadCount(concurrency > 0 ? concurrency : default_probe_concurrency);
+
+    for (qsizetype i = 0; i < files.size(); i++) {
+        pool.start([&files, results, i]() {
+            results[i] = {files[i], probeFile(files[i])};
+        });
+    }
+
+    pool.waitForDone();
+    return probes;
+}
+
+ZDLMapFile *ZDLMapFile::Probe::open(const DirOptions &dirOptions) const {
+    ZDLMapFile *mapfile;
+
+    switch (type) {
+        case Directory:
+            //Directories aren't cached, their contents may change without touching them
+            return new ZLibDir(file, dirOptions.recursive, dirOptions.concurrency);
+        case Wad:
+            mapfile = new DoomWad(file);
+            break;
+        case PK3:
+            mapfile = new ZLibPK3(file);
+            break;
+        case SevenZip:
+            mapfile = new ZLib7z(file);
+            break;
+        default:
+            return nullptr;
     }
 
-    return mapfile;
+    return new ZDLCachedMapFile(file, mapfile);
 }
@@ -21,10 +21,43 @@
 
 
 #include <QString>
+#include <QVector>
+
+class ZDLConf;
 
 class ZDLMapFile {
 public:
-    static ZDLMapFile *getMapFile(const QString &file);
+    enum Type {
+        Unknown,
+        Wad,
+        PK3,
+        SevenZip,
+        Directory
+    };
+
+    // How directories are scanned. Map files are opened on worker threads,
+    // so these are read from the configuration up front and passed down.
+    struct DirOptions {
+        bool recursive = false;
+        int concurrency = 0;
+
+        // Call this where zconf can't go away under it, the GUI thread
+        static DirOptions fromConfig(ZDLConf *zconf);
+    };
+
+    // What probe() made of a file, open() gets the matching map file
+    struct Probe {
+        QString file;
+        Type type = Unknown;
+
+        ZDLMapFile *open(const DirOptions &dirOptions = {}) const;
+    };
+
+    static ZDLMapFile *getMapFile(const QString &file, const DirOptions &dirOptions = {});
+
+    // Classifies files by their magic numbers, reading up to concurrency of
+    // them at once (0 picks a default). Results are in the order of files.
+    static QVector<Probe> probe(const QStringList &files, int concurrency = 0);
 
     virtual QString getIwadinfoName() = 0;
 
@@ -0,0 +1,249 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QDir>
+#include <utility>
+#include "ZDLMetaCache.h"
+#include "ZDLConfigurationManager.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace {
+    const quint32 cache_magic = 0x4D4C445A;    //"ZDLM"
+    const quint32 cache_version = 3;
+    const char cache_file_name[] = "qzdl-cache.bin";
+}
+
+ZDLMetaCache *ZDLMetaCache::getInstance() {
+    static ZDLMetaCache instance;
+    return &instance;
+}
+
+ZDLMetaCache::Key ZDLMetaCache::getKey(const QString &file) {
+    QFileInfo file_info(file);
+    Key key;
+
+    key.path = file_info.canonicalFilePath();
+    if (key.path.isEmpty()) {
+        return key;
+    }
+
+    key.size = file_info.size();
+    key.modified = file_info.lastModified().toMSecsSinceEpoch();
+
+#ifndef _WIN32
+    //Qt doesn't expose inodes, and Windows has no cheap equivalent of them
+    struct stat file_stat{};
+    if (stat(QFile::encodeName(key.path).constData(), &file_stat) == 0) {
+        key.inode = (quint64) file_stat.st_ino;
+    }
+#endif
+
+    return key;
+}
+
+QString ZDLMetaCache::getCacheFileName() {
+    ZDLConfiguration *conf = ZDLConfigurationManager::getConfiguration();
+    if (!conf) {
+        return {};
+    }
+
+    return QFileInfo(conf->getPath(ZDLConfiguration::CONF_USER)).absoluteDir().filePath(cache_file_name);
+}
+
+void ZDLMetaCache::load() {
+    loaded = true;
+
+    QFile cache_file(getCacheFileName());
+    if (!cache_file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&cache_file);
+    stream.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+
+    //Anything from another version is simply rebuilt
+    if (magic != cache_magic || version != cache_version) {
+        return;
+    }
+
+    //count isn't trusted to size anything, a damaged file could claim billions
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        Record record;
+        stream >> record.key.path >> record.key.size >> record.key.modified >> record.key.inode
+               >> record.entry.known >> record.entry.isMAPXX >> record.entry.mapNames
+               >> record.entry.iwadinfoName >> record.entry.digests.md5 >> record.entry.digests.sha1
+               >> record.entry.digests.crc32;
+
+        if (stream.status() == QDataStream::Ok) {
+            records.insert(record.key.path, record);
+        }
+    }
+}
+
+ZDLMetaCache::Entry ZDLMetaCache::lookup(const QString &file) {
+    Key key = getKey(file);
+    if (key.path.isEmpty()) {
+        return {};
+    }
+
+    QMutexLocker locker(&mutex);
+    if (!loaded) {
+        load();
+    }
+
+    auto it = records.constFind(key.path);
+    if (it == records.constEnd() || it->key.size != key.size || it->key.modified != key.modified
+        || it->key.inode != key.inode) {
+        return {};
+    }
+
+    return it->entry;
+}
+
+void ZDLMetaCache::store(const QString &file, const Entry &entry) {
+    Key key = getKey(file);
+    if (key.path.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    if (!loaded) {
+        load();
+    }
+
+    Record &record = records[key.path];
+    if (record.key.size != key.size || record.key.modified != key.modified || record.key.inode != key.inode) {
+        record = Record();
+        record.key = key;
+    }
+
+    if (entry.known & MapNames) {
+        record.entry.mapNames = entry.mapNames;
+    }
+
+    if (entry.known & MAPXX) {
+        record.entry.isMAPXX = entry.isMAPXX;
+    }
+
+    if (entry.known & IwadinfoName) {
+        record.entry.iwadinfoName = entry.iwadinfoName;
+    }
+
+    if (entry.known & Digests) {
+        record.entry.digests = entry.digests;
+    }
+
+    record.entry.known |= entry.known;
+    dirty = true;
+}
+
+void ZDLMetaCache::save() {
+    QMutexLocker locker(&mutex);
+    if (!dirty) {
+        return;
+    }
+
+    QSaveFile cache_file(getCacheFileName());
+    if (!cache_file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    //Forget files that went away since they were cached
+    for (auto it = records.begin(); it != records.end();) {
+        if (QFileInfo::exists(it.key())) {
+            ++it;
+        } else {
+            it = records.erase(it);
+        }
+    }
+
+    QDataStream stream(&cache_file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << cache_magic << cache_version << (quint32) records.size();
+
+    for (const Record &record: records) {
+        stream << record.key.path << record.key.size << record.key.modified << record.key.inode
+               << record.entry.known << record.entry.isMAPXX << record.entry.mapNames
+               << record.entry.iwadinfoName << record.entry.digests.md5 << record.entry.digests.sha1
+               << record.entry.digests.crc32;
+    }
+
+    if (stream.status() == QDataStream::Ok && cache_file.commit()) {
+        dirty = false;
+    }
+}
+
+ZDLCachedMapFile::ZDLCachedMapFile(QString file, ZDLMapFile *mapfile) :
+        file(std::move(file)),
+        mapfile(mapfile) {
+}
+
+ZDLCachedMapFile::~ZDLCachedMapFile() {
+    delete mapfile;
+}
+
+QString ZDLCachedMapFile::getIwadinfoName() {
+    ZDLMetaCache *cache = ZDLMetaCache::getInstance();
+    ZDLMetaCache::Entry entry = cache->lookup(file);
+
+    if (!(entry.known & ZDLMetaCache::IwadinfoName)) {
+        entry.iwadinfoName = mapfile->getIwadinfoName();
+        entry.known = ZDLMetaCache::IwadinfoName;
+        cache->store(file, entry);
+    }
+
+    return entry.iwadinfoName;
+}
+
+QStringList ZDLCachedMapFile::getMapNames() {
+    ZDLMetaCache *cache = ZDLMetaCache::getInstance();
+    ZDLMetaCache::Entry entry = cache->lookup(file);
+
+    if (!(entry.known & ZDLMetaCache::MapNames)) {
+        entry.mapNames = mapfile->getMapNames();
+        entry.known = ZDLMetaCache::MapNames;
+        cache->store(file, entry);
+        ZDLFingerprint::schedule(file);
+    }
+
+    return entry.mapNames;
+}
+
+bool ZDLCachedMapFile::isMAPXX() {
+    ZDLMetaCache *cache = ZDLMetaCache::getInstance();
+    ZDLMetaCache::Entry entry = cache->lookup(file);
+
+    if (!(entry.known & ZDLMetaCache::MAPXX)) {
+        entry.isMAPXX = mapfile->isMAPXX();
+        entry.known = ZDLMetaCache::MAPXX;
+        cache->store(file, entry);
+    }
+
+    return entry.isMAPXX;
+}
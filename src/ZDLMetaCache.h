@@ -0,0 +1,104 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include "ZDLMapFile.h"
+#include "ZDLFingerprint.h"
+
+// Metadata about WADs and archives that survives between sessions. Records
+// are keyed by canonical path and dropped as soon as the file's size,
+// modification time or inode change. The cache lives in a flat binary file
+// next to the user config.
+class ZDLMetaCache {
+public:
+    // Which of the fields of an Entry hold cached data
+    enum Field : quint8 {
+        MapNames = 1,
+        MAPXX = 2,
+        IwadinfoName = 4,
+        Digests = 8
+    };
+
+    struct Entry {
+        quint8 known = 0;
+        bool isMAPXX = false;
+        QStringList mapNames;
+        QString iwadinfoName;
+        ZDLFingerprint digests;
+    };
+
+    static ZDLMetaCache *getInstance();
+
+    // Cached data for file, an Entry with nothing known if there is none
+    // or the file changed since it was stored
+    Entry lookup(const QString &file);
+
+    // Merges the known fields of entry into the record for file
+    void store(const QString &file, const Entry &entry);
+
+    // Writes the cache back to disk if anything changed
+    void save();
+
+private:
+    struct Key {
+        QString path;
+        qint64 size = -1;
+        qint64 modified = 0;
+        quint64 inode = 0;
+    };
+
+    struct Record {
+        Key key;
+        Entry entry;
+    };
+
+    ZDLMetaCache() = default;
+
+    static Key getKey(const QString &file);
+
+    static QString getCacheFileName();
+
+    void load();
+
+    QMutex mutex;
+    QHash<QString, Record> records;
+    bool loaded = false;
+    bool dirty = false;
+};
+
+// Answers ZDLMapFile queries from ZDLMetaCache, only falling back on the
+// wrapped map file for what isn't cached yet
+class ZDLCachedMapFile : public ZDLMapFile {
+private:
+    QString file;
+    ZDLMapFile *mapfile;
+public:
+    // Takes ownership of mapfile
+    ZDLCachedMapFile(QString file, ZDLMapFile *mapfile);
+
+    QString getIwadinfoName() override;
+
+    QStringList getMapNames() override;
+
+    bool isMAPXX() override;
+
+    ~ZDLCachedMapFile() override;
+};
@@ -270,7 +270,7 @@ void ZDLMultiPane::ModePlayerChanged([[maybe_unused]] int idx) {
 
 void ZDLMultiPane::newConfig() {
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
-    ZDLSection *section = zconf->getSection("zdl.save");
+    const ZDLSection *section = zconf->getSection("zdl.save");
 
     if (section && section->hasVariable("host")) {
         tHostAddy->setText(section->findVariable("host"));
@@ -92,12 +92,31 @@ void ZDLNameInput::browse() {
     if (!fileName.isEmpty()) {
         lfile->setText(QFD_QT_SEP(fileName));
         if (zdl_fi) {
+            bool pending = false;
             zdl_fi->setFile(fileName);
-            lname->setText(zdl_fi->GetFileDescription());
+            lname->setText(zdl_fi->GetCachedDescription(&pending));
+
+            //Hashing a large IWAD takes a while, name it once that is done
+            if (pending) {
+                QString provisional = lname->text();
+                zdl_fi->IdentifyLater(this, [this, fileName, provisional]() {
+                    identified(fileName, provisional);
+                });
+            }
         }
     }
 }
 
+void ZDLNameInput::identified(const QString &file, const QString &provisional) {
+    //Leave it alone if another file was picked or the name was edited since
+    if (zdl_fi->filePath() != file || lname->text() != provisional) {
+        return;
+    }
+
+    bool pending;
+    lname->setText(zdl_fi->GetCachedDescription(&pending));
+}
+
 void ZDLNameInput::okClick() {
     QFileInfo selected_file(lfile->text());
 
@@ -51,6 +51,9 @@ public slots:
     void okClick();
 
 protected:
+    // Renames file, provisionally named so far, now that it's identified
+    void identified(const QString &file, const QString &provisional);
+
     ZDLFileInfo *zdl_fi;
     QString last_used_dir;
     bool alllow_dirs;
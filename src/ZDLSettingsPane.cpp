@@ -23,8 +23,11 @@
 #include <QLabel>
 #include <QLineEdit>
 #include <QMouseEvent>
+#include <QPointer>
+#include <QThreadPool>
 #include <QVBoxLayout>
 #include "ZDLMapFile.h"
+#include "ZDLMetaCache.h"
 #include "ZDLConfigurationManager.h"
 #include "ZDLSettingsPane.h"
 
@@ -52,6 +55,7 @@ ZDLSettingsPane::ZDLSettingsPane(QWidget *parent) : ZDLWidget(parent) {
 
     IWADList = new DeselectableListWidget(this);
     IWADList->setItemDelegate(new AlwaysFocusedDelegate());
+    connect(IWADList, SIGNAL(currentRowChanged(int)), this, SLOT(reloadMapList()));
     box->addWidget(IWADList);
 
     auto *box2 = new QHBoxLayout();
@@ -117,17 +121,22 @@ void DeselectableListWidget::mousePressEvent(QMouseEvent *event) {
 void ZDLSettingsPane::VerbosePopup() {
     warpCombo->lineEdit()->setPlaceholderText("");
     QString current = warpCombo->currentText();
-    int idx;
     emit buildParent(this);
-    warpCombo->setUpdatesEnabled(false);
     reloadMapList();
-    if (current.isEmpty()) {
+    setWarpText(current);
+}
+
+void ZDLSettingsPane::setWarpText(const QString &text) {
+    int idx;
+    warpCombo->setUpdatesEnabled(false);
+    if (text.isEmpty()) {
         warpCombo->setCurrentIndex(0);
         warpCombo->clearEditText();
-    } else if ((idx = warpCombo->findText(current, Qt::MatchFixedString)) > 0) {
+    } else if ((idx = warpCombo->findText(text, Qt::MatchFixedString)) > 0) {
         warpCombo->setCurrentIndex(idx);
     } else {
-        warpCombo->setEditText(current);
+        warpCombo->setCurrentIndex(-1);
+        warpCombo->setEditText(text);
     }
     warpCombo->setUpdatesEnabled(true);
 }
@@ -142,129 +151,122 @@ void ZDLSettingsPane::currentRowChanged(int idx) {
     }
 }
 
-QStringList ZDLSettingsPane::getFilesMaps() {
-    if (ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration()) {
-        if (ZDLSection *section = zconf->getSection("zdl.save")) {
-            QVector<ZDLLine *> vctr;
-
-            section->getRegex("^file[0-9]+$", vctr);
-            if (!vctr.empty()) {
-                QStringList maps;
-
-                for (ZDLLine *line: vctr) {
-                    if (ZDLMapFile *mapfile = ZDLMapFile::getMapFile(line->getValue())) {
-                        maps += mapfile->getMapNames();
-                        delete mapfile;
-                    }
-                }
+QStringList ZDLSettingsPane::getMapSources() {
+    QStringList sources;
+
+    if (QListWidgetItem *item = IWADList->currentItem()) {
+        sources += item->data(32).toString();
+    }
 
-                return maps;
+    if (ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration()) {
+        if (const ZDLSection *section = zconf->getSection("zdl.save")) {
+            for (auto &i: section->list("file")) {
+                sources += i.line->getValue();
             }
         }
     }
 
-    return {};
+    return sources;
 }
 
-bool ZDLSettingsPane::naturalSortLess(const QString &left, const QString &right) {
-    //Less comparison algorithm for natural sorting
-    //Based on "The Alphanum Algorithm" by David Koelle
-    //http://www.davekoelle.com/alphanum.html
-    //Released under MIT License (https://opensource.org/licenses/MIT)
-
-    bool mode_letter = true;    //If it's not letter mode, then it's digit mode
-    QString::const_iterator li = left.begin();
-    QString::const_iterator ri = right.begin();
-    bool l_is_digit, r_is_digit;
-    unsigned int l_as_uint, r_as_uint, l_digits, r_digits;
-
-    while (li != left.end() && ri != right.end()) {
-        if (mode_letter) {
-            while (li != left.end() && ri != right.end()) {
-                //Check if these are digit characters
-                l_is_digit = li->isDigit();
-                r_is_digit = ri->isDigit();
-
-                //If both characters are digits, we continue in digit mode
-                if (l_is_digit && r_is_digit) {
-                    mode_letter = false;
-                    break;
-                }
+void ZDLSettingsPane::reloadMapList() {
+    LOGDATAO() << "reloadMapList START" << Qt::endl;
 
-                //If one of the characters is a digit, we have a result
-                if (l_is_digit) return true;
-                if (r_is_digit) return false;
+    QStringList sources = getMapSources();
+    sources.removeDuplicates();
 
-                //Else, compare both characters and if they differ we have a result
-                if (*li < *ri) return true;
-                if (*li > *ri) return false;
+    //Reordering files doesn't change the list, and whatever is still loading
+    //for the same files keeps streaming in
+    QSet<QString> wanted(sources.begin(), sources.end());
+    if (wanted == mapSources) {
+        return;
+    }
 
-                //Otherwise, process next characters
-                ++li;
-                ++ri;
-            }
-        } else {
-            //Get left and right numbers
-            //To prevent overflow we process maximum of 9 digits (ignoring leading zeroes)
-            //It's ok for WAD map names because they are limited to 8 characters anyway
-
-            l_as_uint = 0;
-            l_digits = 0;
-            while (li != left.end() && li->isDigit() && l_digits < 9) {
-                l_as_uint = l_as_uint * 10 + li->digitValue();
-                if (l_as_uint) l_digits++;
-                ++li;
-            }
+    if (mapLoadCancelled) {
+        *mapLoadCancelled = true;
+        mapLoadCancelled.reset();
+    }
 
-            r_as_uint = 0;
-            r_digits = 0;
-            while (ri != right.end() && ri->isDigit() && r_digits < 9) {
-                r_as_uint = r_as_uint * 10 + ri->digitValue();
-                if (r_as_uint) r_digits++;
-                ++ri;
-            }
+    mapSources = wanted;
+
+    for (const QString &source: mapCatalog.sources()) {
+        if (!wanted.contains(source)) {
+            applyMapChange(mapCatalog.removeSource(source));
+        }
+    }
 
-            //If numbers differ, we have a comparison result
-            if (l_as_uint < r_as_uint) return true;
-            if (l_as_uint > r_as_uint) return false;
+    //Show what is cached right away and only scan the rest
+    QStringList uncached;
+    for (const QString &file: sources) {
+        if (mapCatalog.hasSource(file)) {
+            continue;
+        }
 
-            //Otherwise we process the next substring in letter mode
-            mode_letter = true;
+        ZDLMetaCache::Entry entry = ZDLMetaCache::getInstance()->lookup(file);
+        if (entry.known & ZDLMetaCache::MapNames) {
+            applyMapChange(mapCatalog.setSource(file, entry.mapNames));
+        } else {
+            uncached += file;
         }
     }
 
-    //We got here, so one of the strings (or both) is out of characters
-    //If right string still has some characters left, then left string is out of characters, so it is "less" than right
-    if (ri != right.end()) return true;
+    if (uncached.isEmpty()) {
+        return;
+    }
 
-    //Otherwise right is "less" then left or "equal" to it
-    return false;
-}
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    QPointer<ZDLSettingsPane> pane(this);
+    mapLoadCancelled = cancelled;
 
-void ZDLSettingsPane::reloadMapList() {
-    LOGDATAO() << "reloadMapList START" << Qt::endl;
+    //The configuration may be replaced while the scan runs, don't touch it there
+    ZDLMapFile::DirOptions dir_options =
+            ZDLMapFile::DirOptions::fromConfig(ZDLConfigurationManager::getActiveConfiguration());
 
-    warpCombo->clear();
-    warpCombo->addItem("(Default)");
+    QThreadPool::globalInstance()->start([pane, uncached, cancelled, dir_options]() {
+        for (const QString &file: uncached) {
+            if (*cancelled) {
+                return;
+            }
 
-    QStringList wadMaps;
+            QStringList names;
+            if (ZDLMapFile *mapfile = ZDLMapFile::getMapFile(file, dir_options)) {
+                names = mapfile->getMapNames();
+                delete mapfile;
+            }
 
-    if (QListWidgetItem *item = IWADList->currentItem()) {
-        if (ZDLMapFile *mapfile = ZDLMapFile::getMapFile(item->data(32).toString())) {
-            wadMaps += mapfile->getMapNames();
-            delete mapfile;
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [pane, file, names, cancelled]() {
+                if (pane && !*cancelled) {
+                    pane->applyMapChange(pane->mapCatalog.setSource(file, names));
+                }
+            }, Qt::QueuedConnection);
         }
+    });
+}
+
+void ZDLSettingsPane::applyMapChange(const ZDLMapCatalog::Change &change) {
+    if (change.added.isEmpty() && change.removed.isEmpty()) {
+        return;
     }
 
-    wadMaps.append(getFilesMaps());
+    QString current = warpCombo->currentText();
+
+    for (const QString &name: change.removed) {
+        int idx = warpCombo->findText(name, Qt::MatchExactly | Qt::MatchCaseSensitive);
+        if (idx > 0) {
+            warpCombo->removeItem(idx);
+        }
+    }
 
-    if (!wadMaps.empty()) {
-        std::sort(wadMaps.begin(), wadMaps.end(), naturalSortLess);
-        wadMaps.removeDuplicates();
-        warpCombo->addItems(wadMaps);
+    //Everything sorting before an added name is in place by the time it is
+    //inserted, so its catalog position is its position in the combo
+    for (int i = 0; i < change.added.size(); i++) {
+        warpCombo->insertItem(change.addedAt[i] + 1, change.added[i]);
     }
 
-    warpCombo->setCurrentIndex(-1);
+    //Updating the list must not change what is typed in or picked
+    if (warpCombo->currentText() != current) {
+        setWarpText(current);
+    }
 }
 
 void ZDLSettingsPane::rebuild() {
@@ -290,29 +292,16 @@ void ZDLSettingsPane::rebuild() {
     }
 
     bool set = false;
-    ZDLSection *section = zconf->getSection("zdl.ports");
+    const ZDLSection *section = zconf->getSection("zdl.ports");
     if (section) {
         int count = 0;
-        QVector<ZDLLine *> fileVctr;
-        section->getRegex(QString("^p[0-9]+f$"), fileVctr);
-
-        for (auto &i: fileVctr) {
-            QString value = i->getVariable();
-
-            QString number = "^p";
-            number.append(value.mid(1, value.length() - 2));
-            number.append("n$");
-
-            QVector<ZDLLine *> nameVctr;
-            section->getRegex(number, nameVctr);
-            if (nameVctr.size() == 1) {
-                if (sourceList->currentIndex() == count) {
-                    zconf->setValue("zdl.save", "port", nameVctr[0]->getValue());
-                    set = true;
-                    break;
-                }
-                count++;
+        for (auto &i: section->pairs("p", "f", "n")) {
+            if (sourceList->currentIndex() == count) {
+                zconf->setValue("zdl.save", "port", i.second->getValue());
+                set = true;
+                break;
             }
+            count++;
         }
     }
     if (!set) zconf->deleteValue("zdl.save", "port");
@@ -321,26 +310,13 @@ void ZDLSettingsPane::rebuild() {
     section = zconf->getSection("zdl.iwads");
     if (section) {
         int count = 0;
-        QVector<ZDLLine *> fileVctr;
-        section->getRegex("^i[0-9]+f$", fileVctr);
-
-        for (auto &i: fileVctr) {
-            QString value = i->getVariable();
-
-            QString number = "^i";
-            number.append(value.mid(1, value.length() - 2));
-            number.append("n$");
-
-            QVector<ZDLLine *> nameVctr;
-            section->getRegex(number, nameVctr);
-            if (nameVctr.size() == 1) {
-                if (IWADList->currentRow() == count) {
-                    zconf->setValue("zdl.save", "iwad", nameVctr[0]->getValue());
-                    set = true;
-                    break;
-                }
-                count++;
+        for (auto &i: section->pairs("i", "f", "n")) {
+            if (IWADList->currentRow() == count) {
+                zconf->setValue("zdl.save", "iwad", i.second->getValue());
+                set = true;
+                break;
             }
+            count++;
         }
     }
     if (!set) zconf->deleteValue("zdl.save", "iwad");
@@ -392,23 +368,11 @@ void ZDLSettingsPane::newConfig() {
     }
 
     sourceList->clear();
-    ZDLSection *section = zconf->getSection("zdl.ports");
+    const ZDLSection *section = zconf->getSection("zdl.ports");
     if (section) {
-        QVector<ZDLLine *> fileVctr;
-        section->getRegex("^p[0-9]+f$", fileVctr);
-
-        for (auto &i: fileVctr) {
-            QString value = i->getVariable();
-
-            QString number = "^p";
-            number.append(value.mid(1, value.length() - 2));
-            number.append("n$");
+        for (auto &i: section->pairs("p", "f", "n")) {
             int stat = 0;
-            QVector<ZDLLine *> nameVctr;
-            section->getRegex(number, nameVctr);
-            if (nameVctr.size() == 1) {
-                sourceList->addItem(nameVctr[0]->getValue(), stat);
-            }
+            sourceList->addItem(i.second->getValue(), stat);
         }
     }
 
@@ -435,23 +399,10 @@ void ZDLSettingsPane::newConfig() {
     IWADList->clear();
     section = zconf->getSection("zdl.iwads");
     if (section) {
-        QVector<ZDLLine *> fileVctr;
-        section->getRegex("^i[0-9]+f$", fileVctr);
-
-        for (auto &i: fileVctr) {
-            QString value = i->getVariable();
-
-            QString number = "^i";
-            number.append(value.mid(1, value.length() - 2));
-            number.append("n$");
-
-            QVector<ZDLLine *> nameVctr;
-            section->getRegex(number, nameVctr);
-            if (nameVctr.size() == 1) {
-                auto *item = new QListWidgetItem(nameVctr[0]->getValue(), IWADList, 1001);
-                item->setData(32, i->getValue());
-                IWADList->addItem(item);
-            }
+        for (auto &i: section->pairs("i", "f", "n")) {
+            auto *item = new QListWidgetItem(i.second->getValue(), IWADList, 1001);
+            item->setData(32, i.first->getValue());
+            IWADList->addItem(item);
         }
     }
 
@@ -24,6 +24,10 @@
 #include <QComboBox>
 #include <QItemDelegate>
 #include <QStyledItemDelegate>
+#include <QSet>
+#include <atomic>
+#include <memory>
+#include "ZDLMapCatalog.h"
 #include "ZDLWidget.h"
 
 class ZDLSettingsPane : public ZDLWidget {
@@ -47,7 +51,13 @@ protected slots:
     void HidePopup();
 
 protected:
-    static QStringList getFilesMaps();
+    // The selected IWAD followed by every fileN of the current config
+    QStringList getMapSources();
+
+    void setWarpText(const QString &text);
+
+    // Brings warpCombo in line with mapCatalog after it changed
+    void applyMapChange(const ZDLMapCatalog::Change &change);
 
     QComboBox *diffList;
     QComboBox *monstersList;
@@ -55,7 +65,11 @@ protected:
     QListWidget *IWADList;
     QComboBox *warpCombo;
 
-    static bool naturalSortLess(const QString &lm, const QString &rm);
+    // Map names are loaded in the background and streamed into warpCombo.
+    // Changing the sources cancels the load in progress.
+    QSet<QString> mapSources;
+    ZDLMapCatalog mapCatalog;
+    std::shared_ptr<std::atomic<bool>> mapLoadCancelled;
 };
 
 class AlwaysFocusedDelegate : public QItemDelegate {
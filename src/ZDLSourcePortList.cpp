@@ -56,33 +56,20 @@ void ZDLSourcePortList::wizardAddButton() {
 void ZDLSourcePortList::newConfig() {
     pList->clear();
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
-    ZDLSection *section = zconf->getSection("zdl.ports");
+    const ZDLSection *section = zconf->getSection("zdl.ports");
     if (section) {
-        QVector<ZDLLine *> fileVctr;
-        section->getRegex("^p[0-9]+f$", fileVctr);
-
-        for (auto &i: fileVctr) {
-            QString value = i->getVariable();
-
-            QString number = "^p";
-            number.append(value.mid(1, value.length() - 2));
-            number.append("n$");
-
-            QVector<ZDLLine *> nameVctr;
-            section->getRegex(number, nameVctr);
-            if (nameVctr.size() == 1) {
-                QString disName = nameVctr[0]->getValue();
-                QString fileName = i->getValue();
-                auto *zList = new ZDLNameListable(pList, 1001, fileName, disName);
-                insert(zList, -1);
-            }
+        for (auto &i: section->pairs("p", "f", "n")) {
+            QString disName = i.second->getValue();
+            QString fileName = i.first->getValue();
+            auto *zList = new ZDLNameListable(pList, 1001, fileName, disName);
+            insert(zList, -1);
         }
     }
 }
 
 void ZDLSourcePortList::rebuild() {
     ZDLConf *zconf = ZDLConfigurationManager::getActiveConfiguration();
-    ZDLSection *section = zconf->getSection("zdl.ports");
+    const ZDLSection *section = zconf->getSection("zdl.ports");
     if (section) {
         zconf->deleteSection("zdl.ports");
     }
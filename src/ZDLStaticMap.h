@@ -0,0 +1,249 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <QByteArray>
+#include <QStringView>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+// Read-only tables that are laid out entirely at compile time. Keys are
+// placed with a hash-and-displace perfect hash, so a lookup hashes the key
+// twice and compares it against a single slot, without allocating. A table
+// with duplicate keys fails to compile.
+
+namespace ZDLStaticMapHash {
+    constexpr std::uint64_t mix(std::uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    constexpr std::uint64_t seeded(std::uint64_t seed) {
+        return mix(seed * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL);
+    }
+}
+
+// 16 byte binary MD5 digests
+struct ZDLMd5Key {
+    using Type = std::array<std::uint8_t, 16>;
+
+    static consteval Type fromHex(std::string_view hex) {
+        if (hex.size() != 32) {
+            throw "MD5 digests are 32 hex digits";
+        }
+
+        Type md5{};
+        for (std::size_t i = 0; i < hex.size(); i++) {
+            char c = hex[i];
+            int nibble;
+
+            if (c >= '0' && c <= '9') {
+                nibble = c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                nibble = c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                nibble = c - 'A' + 10;
+            } else {
+                throw "Invalid hex digit in MD5 digest";
+            }
+
+            md5[i / 2] |= (std::uint8_t) (nibble << (i % 2 ? 0 : 4));
+        }
+
+        return md5;
+    }
+
+    // Digests that aren't 16 bytes long come out as all zeroes
+    static Type fromBytes(const QByteArray &bytes) {
+        Type md5{};
+        if (bytes.size() == (int) md5.size()) {
+            std::copy(bytes.begin(), bytes.end(), md5.begin());
+        }
+        return md5;
+    }
+
+    static constexpr std::uint64_t hash(const Type &key, std::uint64_t seed) {
+        //Digests are uniformly distributed already, half of one is plenty
+        std::uint64_t h = 0;
+        for (std::size_t i = 0; i < 8; i++) {
+            h |= (std::uint64_t) key[i] << (i * 8);
+        }
+        return ZDLStaticMapHash::mix(h ^ ZDLStaticMapHash::seeded(seed));
+    }
+
+    static constexpr bool equal(const Type &a, const Type &b) {
+        return a == b;
+    }
+};
+
+// ASCII names compared case-insensitively, looked up with a QStringView
+struct ZDLNameKey {
+    using Type = std::string_view;
+
+    static constexpr char16_t fold(char16_t c) {
+        return c >= u'A' && c <= u'Z' ? (char16_t) (c + (u'a' - u'A')) : c;
+    }
+
+    static constexpr char16_t unit(char c) {
+        return (char16_t) (unsigned char) c;
+    }
+
+    static constexpr char16_t unit(QChar c) {
+        return c.unicode();
+    }
+
+    template<class String>
+    static constexpr std::uint64_t hash(const String &key, std::uint64_t seed) {
+        std::uint64_t h = 0xCBF29CE484222325ULL ^ ZDLStaticMapHash::seeded(seed);
+        for (auto c: key) {
+            h = (h ^ fold(unit(c))) * 0x100000001B3ULL;
+        }
+        return ZDLStaticMapHash::mix(h);
+    }
+
+    template<class String>
+    static constexpr bool equal(const Type &a, const String &b) {
+        if (a.size() != (std::size_t) b.size()) {
+            return false;
+        }
+
+        auto it = b.begin();
+        for (char c: a) {
+            if (fold(unit(c)) != fold(unit(*it++))) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+template<class Key, std::size_t N>
+class ZDLStaticMap {
+public:
+    using Entry = std::pair<typename Key::Type, const char *>;
+
+    consteval explicit ZDLStaticMap(const std::array<Entry, N> &entries) {
+        std::array<std::size_t, N> bucket_of{};
+        std::array<std::size_t, bucket_count> bucket_sizes{};
+        std::size_t largest = 0;
+
+        for (std::size_t i = 0; i < N; i++) {
+            for (std::size_t j = 0; j < i; j++) {
+                if (Key::equal(entries[i].first, entries[j].first)) {
+                    throw "Duplicate key in static map";
+                }
+            }
+
+            bucket_of[i] = Key::hash(entries[i].first, 0) % bucket_count;
+            largest = std::max(largest, ++bucket_sizes[bucket_of[i]]);
+        }
+
+        //Place the crowded buckets first while most slots are still free
+        std::array<bool, slot_count> taken{};
+        for (std::size_t size = largest; size > 0; size--) {
+            for (std::size_t bucket = 0; bucket < bucket_count; bucket++) {
+                if (bucket_sizes[bucket] == size) {
+                    place(entries, bucket_of, bucket, taken);
+                }
+            }
+        }
+    }
+
+    // Value stored for key, nullptr if there is none
+    template<class K>
+    constexpr const char *find(const K &key) const {
+        std::size_t bucket = Key::hash(key, 0) % bucket_count;
+        const Entry &slot = slots[Key::hash(key, displacements[bucket]) & (slot_count - 1)];
+
+        if (slot.second && Key::equal(slot.first, key)) {
+            return slot.second;
+        }
+
+        return nullptr;
+    }
+
+    static constexpr std::size_t size() {
+        return N;
+    }
+
+private:
+    static constexpr std::size_t slot_count = std::bit_ceil(N + N / 4 + 1);
+    static constexpr std::size_t bucket_count = N / 2 + 1;
+    static constexpr std::uint32_t max_displacement = 1 << 16;
+
+    consteval void place(const std::array<Entry, N> &entries, const std::array<std::size_t, N> &bucket_of,
+                         std::size_t bucket, std::array<bool, slot_count> &taken) {
+        std::array<std::size_t, N> chosen{};
+
+        for (std::uint32_t displacement = 1; displacement < max_displacement; displacement++) {
+            std::size_t count = 0;
+            bool fits = true;
+
+            for (std::size_t i = 0; i < N && fits; i++) {
+                if (bucket_of[i] != bucket) {
+                    continue;
+                }
+
+                std::size_t slot = Key::hash(entries[i].first, displacement) & (slot_count - 1);
+                fits = !taken[slot];
+                for (std::size_t j = 0; j < count && fits; j++) {
+                    fits = chosen[j] != slot;
+                }
+                chosen[count++] = slot;
+            }
+
+            if (!fits) {
+                continue;
+            }
+
+            count = 0;
+            for (std::size_t i = 0; i < N; i++) {
+                if (bucket_of[i] == bucket) {
+                    taken[chosen[count]] = true;
+                    slots[chosen[count++]] = entries[i];
+                }
+            }
+
+            displacements[bucket] = displacement;
+            return;
+        }
+
+        throw "No perfect hash displacement found for static map";
+    }
+
+    std::array<std::uint32_t, bucket_count> displacements{};
+    std::array<Entry, slot_count> slots{};
+};
+
+// Builds a table from a braced list of {key, value} pairs
+template<class Key, std::size_t N>
+consteval ZDLStaticMap<Key, N> makeStaticMap(std::pair<typename Key::Type, const char *> (&&entries)[N]) {
+    std::array<std::pair<typename Key::Type, const char *>, N> table{};
+    for (std::size_t i = 0; i < N; i++) {
+        table[i] = entries[i];
+    }
+    return ZDLStaticMap<Key, N>(table);
+}
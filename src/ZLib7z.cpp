@@ -0,0 +1,744 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QRegularExpression>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include "ZLib7z.h"
+#include "ZLibLZMA.h"
+#include "ZLibMapInfo.h"
+#include "miniz.h"
+
+namespace {
+    const uchar signature[6] = {'7', 'z', 0xBC, 0xAF, 0x27, 0x1C};
+    const int signature_header_size = 32;
+    const qint64 max_header_size = 64 * 1024 * 1024;
+
+    enum PropertyId : quint8 {
+        kEnd = 0x00,
+        kHeader = 0x01,
+        kArchiveProperties = 0x02,
+        kAdditionalStreamsInfo = 0x03,
+        kMainStreamsInfo = 0x04,
+        kFilesInfo = 0x05,
+        kPackInfo = 0x06,
+        kUnPackInfo = 0x07,
+        kSubStreamsInfo = 0x08,
+        kSize = 0x09,
+        kCRC = 0x0A,
+        kFolder = 0x0B,
+        kCodersUnPackSize = 0x0C,
+        kNumUnPackStream = 0x0D,
+        kEmptyStream = 0x0E,
+        kEmptyFile = 0x0F,
+        kName = 0x11,
+        kWinAttributes = 0x15,
+        kEncodedHeader = 0x17
+    };
+
+    const QByteArray method_copy("\x00", 1);
+    const QByteArray method_lzma("\x03\x01\x01", 3);
+    const QByteArray method_lzma2("\x21", 1);
+
+    const quint32 dos_dir_attribute = 0x10;
+
+    quint32 readLE32(const uchar *p) {
+        return (quint32) p[0] | ((quint32) p[1] << 8) | ((quint32) p[2] << 16) | ((quint32) p[3] << 24);
+    }
+
+    quint64 readLE64(const uchar *p) {
+        return (quint64) readLE32(p) | ((quint64) readLE32(p + 4) << 32);
+    }
+
+    QString parseIwadinfo(const QByteArray &iwadinfo) {
+        static QRegularExpression name_re("\\s+Name\\s*=\\s*\"(.+)\"\\s+");
+        QRegularExpressionMatch match = name_re.match(iwadinfo, Qt::CaseInsensitive);
+
+        if (match.hasPartialMatch()) {
+            return match.captured(1);
+        }
+
+        return {};
+    }
+
+    // Directory part of a '/' separated name, empty for root entries
+    QStringView entryPath(const QString &name) {
+        qsizetype slash = name.lastIndexOf('/');
+        return slash < 0 ? QStringView() : QStringView(name).left(slash);
+    }
+
+    QStringView entryFileName(const QString &name) {
+        return QStringView(name).mid(name.lastIndexOf('/') + 1);
+    }
+
+    QStringView entryBaseName(const QString &name) {
+        QStringView file_name = entryFileName(name);
+        qsizetype dot = file_name.indexOf('.');
+        return dot < 0 ? file_name : file_name.left(dot);
+    }
+}
+
+// Bounds checked reader over a (decoded) header. Any read past the end
+// marks the reader as failed and yields zeroes from then on.
+class SevenZipArchive::HeaderReader {
+public:
+    explicit HeaderReader(const QByteArray &data) :
+            pos((const uchar *) data.constData()),
+            end(pos + data.size()) {
+    }
+
+    HeaderReader(const uchar *data, quint64 size) :
+            pos(data),
+            end(data + size) {
+    }
+
+    quint8 byte() {
+        if (pos == end) {
+            failed = true;
+            return 0;
+        }
+
+        return *pos++;
+    }
+
+    // 7z variable length number, the count of leading 1 bits in the first
+    // byte tells how many little endian bytes follow
+    quint64 number() {
+        quint8 first = byte();
+        quint64 value = 0;
+
+        for (int i = 0; i < 8; i++) {
+            quint8 mask = 0x80 >> i;
+            if (!(first & mask)) {
+                return value | ((quint64) (first & (mask - 1)) << (8 * i));
+            }
+
+            value |= (quint64) byte() << (8 * i);
+        }
+
+        return value;
+    }
+
+    // Numbers used as counts, bounded by what could possibly fit in the header
+    int count() {
+        quint64 value = number();
+        if (value > (quint64) (end - pos) * 8 + 1) {
+            failed = true;
+            return 0;
+        }
+
+        return (int) value;
+    }
+
+    const uchar *take(quint64 size) {
+        if (size > (quint64) (end - pos)) {
+            failed = true;
+            pos = end;
+            return nullptr;
+        }
+
+        const uchar *data = pos;
+        pos += size;
+        return data;
+    }
+
+    std::vector<bool> bits(int size) {
+        std::vector<bool> vector(size);
+        quint8 current = 0;
+
+        for (int i = 0; i < size; i++) {
+            if (!(i & 7)) {
+                current = byte();
+            }
+
+            vector[i] = current & (0x80 >> (i & 7));
+        }
+
+        return vector;
+    }
+
+    // Bit vector preceded by an "all defined" byte
+    std::vector<bool> definedBits(int size) {
+        if (byte()) {
+            return std::vector<bool>(size, true);
+        }
+
+        return bits(size);
+    }
+
+    void skipDigests(int size) {
+        std::vector<bool> defined = definedBits(size);
+        take(4 * std::count(defined.begin(), defined.end(), true));
+    }
+
+    bool failed = false;
+
+private:
+    const uchar *pos;
+    const uchar *end;
+};
+
+bool SevenZipArchive::open(const QString &file) {
+    zip.setFileName(file);
+    if (!zip.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    uchar start[signature_header_size];
+    if (zip.read((char *) start, signature_header_size) != signature_header_size
+        || memcmp(start, signature, sizeof(signature)) != 0) {
+        return false;
+    }
+
+    quint64 next_offset = readLE64(start + 12);
+    quint64 next_size = readLE64(start + 20);
+    quint64 file_size = zip.size() - signature_header_size;
+
+    if (next_size == 0 || next_size > (quint64) max_header_size
+        || next_offset > file_size || next_size > file_size - next_offset
+        || !zip.seek(signature_header_size + (qint64) next_offset)) {
+        return false;
+    }
+
+    QByteArray header = zip.read((qint64) next_size);
+    if ((quint64) header.size() != next_size
+        || mz_crc32(MZ_CRC32_INIT, (const uchar *) header.constData(), header.size()) != readLE32(start + 28)) {
+        return false;
+    }
+
+    //Encoded headers are packed streams holding the real header, possibly encoded again
+    for (int level = 0; level < 4; level++) {
+        HeaderReader reader(header);
+        quint8 id = reader.byte();
+
+        if (id == kHeader) {
+            StreamsInfo main;
+
+            id = reader.byte();
+            if (id == kArchiveProperties) {
+                while (!reader.failed && reader.byte() != kEnd) {
+                    reader.take(reader.number());
+                }
+
+                id = reader.byte();
+            }
+
+            if (id == kAdditionalStreamsInfo) {
+                StreamsInfo additional;
+                if (!readStreamsInfo(reader, additional)) {
+                    return false;
+                }
+
+                id = reader.byte();
+            }
+
+            if (id == kMainStreamsInfo) {
+                if (!readStreamsInfo(reader, main)) {
+                    return false;
+                }
+
+                id = reader.byte();
+            }
+
+            folders = main.folders;
+
+            if (id == kFilesInfo) {
+                return readFilesInfo(reader, main);
+            }
+
+            return id == kEnd && !reader.failed;
+        }
+
+        StreamsInfo encoded;
+        if (id != kEncodedHeader || !readStreamsInfo(reader, encoded) || encoded.folders.empty()) {
+            return false;
+        }
+
+        const Folder &folder = encoded.folders.front();
+        if (folder.unpackSize > max_header_size) {
+            return false;
+        }
+
+        header = decode(folder, folder.unpackSize);
+        if (header.size() != folder.unpackSize) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool SevenZipArchive::readStreamsInfo(HeaderReader &reader, StreamsInfo &info) {
+    qint64 pack_pos = 0;
+    std::vector<qint64> pack_sizes;
+    bool has_substreams = false;
+    std::vector<bool> folder_crcs;
+
+    quint8 id = reader.byte();
+
+    if (id == kPackInfo) {
+        pack_pos = (qint64) reader.number();
+        pack_sizes.resize(reader.count());
+
+        for (id = reader.byte(); id != kEnd && !reader.failed; id = reader.byte()) {
+            if (id == kSize) {
+                for (qint64 &size: pack_sizes) {
+                    size = (qint64) reader.number();
+                }
+            } else if (id == kCRC) {
+                reader.skipDigests((int) pack_sizes.size());
+            } else {
+                return false;
+            }
+        }
+
+        id = reader.byte();
+    }
+
+    if (id == kUnPackInfo) {
+        if (reader.byte() != kFolder) {
+            return false;
+        }
+
+        int num_folders = reader.count();
+        if (reader.byte() != 0) {
+            return false;    //External folders aren't used by any known writer
+        }
+
+        std::vector<int> out_streams(num_folders);
+        std::vector<std::vector<int>> bound_outs(num_folders);
+        qint64 pack_offset = signature_header_size + pack_pos;
+        size_t pack_stream = 0;
+
+        for (int i = 0; i < num_folders && !reader.failed; i++) {
+            Folder folder{};
+            int num_coders = reader.count();
+            int total_in = 0;
+
+            for (int c = 0; c < num_coders && !reader.failed; c++) {
+                quint8 flags = reader.byte();
+                if (flags & 0x80) {
+                    return false;
+                }
+
+                const uchar *id_data = reader.take(flags & 0x0F);
+                int num_in = 1;
+                int num_out = 1;
+
+                if (flags & 0x10) {
+                    num_in = reader.count();
+                    num_out = reader.count();
+                }
+
+                QByteArray properties;
+                if (flags & 0x20) {
+                    quint64 size = reader.number();
+                    const uchar *data = reader.take(size);
+                    if (data) {
+                        properties = QByteArray((const char *) data, (qsizetype) size);
+                    }
+                }
+
+                if (num_coders == 1 && id_data) {
+                    folder.method = QByteArray((const char *) id_data, flags & 0x0F);
+                    folder.properties = properties;
+                }
+
+                total_in += num_in;
+                out_streams[i] += num_out;
+            }
+
+            for (int b = 0; b < out_streams[i] - 1; b++) {
+                reader.number();
+                bound_outs[i].push_back((int) reader.number());
+            }
+
+            int num_packed = total_in - (out_streams[i] - 1);
+            if (num_packed < 1) {
+                return false;
+            }
+
+            if (num_packed > 1) {
+                for (int p = 0; p < num_packed; p++) {
+                    reader.number();
+                }
+            }
+
+            //Only single coder folders are decoded, that covers archives written with default settings
+            folder.supported = num_coders == 1 && out_streams[i] == 1
+                               && (folder.method == method_copy || folder.method == method_lzma
+                                   || folder.method == method_lzma2);
+
+            if (pack_stream < pack_sizes.size()) {
+                folder.packOffset = pack_offset;
+                folder.packSize = pack_sizes[pack_stream];
+            } else {
+                folder.supported = false;
+            }
+
+            for (int p = 0; p < num_packed && pack_stream < pack_sizes.size(); p++) {
+                pack_offset += pack_sizes[pack_stream++];
+            }
+
+            folder.numSubstreams = 1;
+            info.folders.push_back(folder);
+        }
+
+        if (reader.byte() != kCodersUnPackSize) {
+            return false;
+        }
+
+        //The folder's size is the size of its only output stream that isn't bound to another coder
+        for (int i = 0; i < num_folders && !reader.failed; i++) {
+            for (int out = 0; out < out_streams[i]; out++) {
+                qint64 size = (qint64) reader.number();
+
+                if (std::find(bound_outs[i].begin(), bound_outs[i].end(), out) == bound_outs[i].end()) {
+                    info.folders[i].unpackSize = size;
+                }
+            }
+        }
+
+        folder_crcs.assign(num_folders, false);
+        for (id = reader.byte(); id != kEnd && !reader.failed; id = reader.byte()) {
+            if (id != kCRC) {
+                return false;
+            }
+
+            folder_crcs = reader.definedBits(num_folders);
+            reader.take(4 * std::count(folder_crcs.begin(), folder_crcs.end(), true));
+        }
+
+        id = reader.byte();
+    }
+
+    if (id == kSubStreamsInfo) {
+        has_substreams = true;
+        id = reader.byte();
+
+        if (id == kNumUnPackStream) {
+            for (Folder &folder: info.folders) {
+                folder.numSubstreams = reader.count();
+            }
+
+            id = reader.byte();
+        }
+
+        for (const Folder &folder: info.folders) {
+            qint64 left = folder.unpackSize;
+
+            for (int s = 0; s < folder.numSubstreams - 1; s++) {
+                qint64 size = id == kSize ? (qint64) reader.number() : 0;
+                info.streamSizes.push_back(size);
+                left -= size;
+            }
+
+            if (folder.numSubstreams) {
+                info.streamSizes.push_back(left);
+            }
+        }
+
+        if (id == kSize) {
+            id = reader.byte();
+        }
+
+        for (; id != kEnd && !reader.failed; id = reader.byte()) {
+            if (id != kCRC) {
+                return false;
+            }
+
+            int unknown = 0;
+            for (size_t i = 0; i < info.folders.size(); i++) {
+                int count = info.folders[i].numSubstreams;
+                unknown += count == 1 && i < folder_crcs.size() && folder_crcs[i] ? 0 : count;
+            }
+
+            reader.skipDigests(unknown);
+        }
+
+        id = reader.byte();
+    }
+
+    if (!has_substreams) {
+        for (const Folder &folder: info.folders) {
+            info.streamSizes.push_back(folder.unpackSize);
+        }
+    }
+
+    return id == kEnd && !reader.failed;
+}
+
+bool SevenZipArchive::readFilesInfo(HeaderReader &reader, const StreamsInfo &info) {
+    int num_files = reader.count();
+    std::vector<bool> empty_stream(num_files, false);
+    std::vector<bool> empty_file;
+    std::vector<bool> directory_attribute(num_files, false);
+    QStringList names;
+
+    for (quint8 type = reader.byte(); type != kEnd && !reader.failed; type = reader.byte()) {
+        quint64 size = reader.number();
+        const uchar *data = reader.take(size);
+
+        if (!data) {
+            return false;
+        }
+
+        HeaderReader property(data, size);
+
+        if (type == kEmptyStream) {
+            empty_stream = property.bits(num_files);
+        } else if (type == kEmptyFile) {
+            empty_file = property.bits((int) std::count(empty_stream.begin(), empty_stream.end(), true));
+        } else if (type == kName) {
+            if (property.byte() != 0) {
+                return false;
+            }
+
+            QString name;
+            while (names.size() < num_files && !property.failed) {
+                quint16 c = property.byte();
+                c |= property.byte() << 8;
+
+                if (c) {
+                    name += c == '\\' ? QChar('/') : QChar(c);
+                } else {
+                    names << name;
+                    name.clear();
+                }
+            }
+        } else if (type == kWinAttributes) {
+            std::vector<bool> defined = property.definedBits(num_files);
+            if (property.byte() != 0) {
+                return false;
+            }
+
+            for (int i = 0; i < num_files; i++) {
+                if (defined[i]) {
+                    const uchar *attributes = property.take(4);
+                    directory_attribute[i] = attributes && (readLE32(attributes) & dos_dir_attribute);
+                }
+            }
+        }
+
+        if (property.failed) {
+            return false;
+        }
+    }
+
+    if (reader.failed || names.size() != num_files) {
+        return false;
+    }
+
+    size_t stream = 0;
+    size_t folder = 0;
+    int folder_stream = 0;
+    qint64 folder_offset = 0;
+    size_t empty_index = 0;
+
+    m_entries.reserve(num_files);
+    for (int i = 0; i < num_files; i++) {
+        Entry entry{names[i], 0, -1, 0, false};
+
+        if (empty_stream[i]) {
+            bool is_empty_file = empty_index < empty_file.size() && empty_file[empty_index];
+            entry.isDirectory = directory_attribute[i] || !is_empty_file;
+            empty_index++;
+        } else {
+            //Skip folders without substreams
+            while (folder < info.folders.size() && folder_stream >= info.folders[folder].numSubstreams) {
+                folder++;
+                folder_stream = 0;
+                folder_offset = 0;
+            }
+
+            if (folder >= info.folders.size() || stream >= info.streamSizes.size()) {
+                return false;
+            }
+
+            entry.size = info.streamSizes[stream++];
+            entry.folder = (int) folder;
+            entry.folderOffset = folder_offset;
+            folder_offset += entry.size;
+            folder_stream++;
+        }
+
+        m_entries.push_back(entry);
+    }
+
+    return true;
+}
+
+QByteArray SevenZipArchive::decode(const Folder &folder, qint64 size) {
+    if (!folder.supported || size > folder.unpackSize) {
+        return {};
+    }
+
+    qint64 position = folder.packOffset;
+    qint64 left = folder.packSize;
+
+    //The QFile is only ever read from here, but seek anyway in case of nested decodes
+    ZLibLZMA::Reader reader = [this, &position, &left](char *data, qint64 max_size) -> qint64 {
+        qint64 read_size = qMin(max_size, left);
+        if (!zip.seek(position) || zip.read(data, read_size) != read_size) {
+            return -1;
+        }
+
+        position += read_size;
+        left -= read_size;
+        return read_size;
+    };
+
+    if (folder.method == method_copy) {
+        QByteArray data(size, Qt::Uninitialized);
+        return reader(data.data(), size) == size ? data : QByteArray();
+    }
+
+    if (folder.method == method_lzma) {
+        return ZLibLZMA::decodeLzma(folder.properties, reader, size);
+    }
+
+    return ZLibLZMA::decodeLzma2(folder.properties, reader, size);
+}
+
+const SevenZipArchive::Entry *SevenZipArchive::findEntry(const QString &name) const {
+    for (const Entry &entry: m_entries) {
+        if (!entry.isDirectory && !entry.name.compare(name, Qt::CaseInsensitive)) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+QByteArray SevenZipArchive::extract(const Entry &entry, qint64 maxSize) {
+    if (entry.folder < 0) {
+        return entry.isDirectory ? QByteArray() : QByteArray("");
+    }
+
+    qint64 end = entry.folderOffset + entry.size;
+    if (end > maxSize || entry.folder >= (int) folders.size()) {
+        return {};
+    }
+
+    if (decodedFolder != entry.folder || decodedData.size() < end) {
+        decodedData = decode(folders[entry.folder], end);
+        decodedFolder = decodedData.size() == end ? entry.folder : -1;
+
+        if (decodedFolder < 0) {
+            return {};
+        }
+    }
+
+    return decodedData.mid(entry.folderOffset, entry.size);
+}
+
+ZLib7z::ZLib7z(QString file) :
+        file(std::move(file)) {
+}
+
+ZLib7z::~ZLib7z()
+= default;
+
+SevenZipArchive &ZLib7z::archive() {
+    if (!m_opened) {
+        m_archive.open(file);
+        m_opened = true;
+    }
+
+    return m_archive;
+}
+
+QStringList ZLib7z::getMapNames() {
+    QStringList map_names;
+    const SevenZipArchive::Entry *mapinfo = nullptr;
+    const SevenZipArchive::Entry *zmapinfo = nullptr;
+
+    for (const SevenZipArchive::Entry &entry: archive().entries()) {
+        if (entry.isDirectory) {
+            continue;
+        }
+
+        QStringView path = entryPath(entry.name);
+        if (!path.compare(QLatin1String("maps"), Qt::CaseInsensitive)) {
+            map_names << entryBaseName(entry.name).left(8).toString().toUpper();
+        } else if (path.isEmpty()) {
+            QStringView base_name = entryBaseName(entry.name);
+
+            if (!mapinfo && !base_name.compare(QLatin1String("mapinfo"), Qt::CaseInsensitive)) {
+                mapinfo = &entry;
+            } else if (!zmapinfo && !base_name.compare(QLatin1String("zmapinfo"), Qt::CaseInsensitive)) {
+                zmapinfo = &entry;
+            }
+        }
+    }
+
+    auto open = [this](const SevenZipArchive::Entry *entry) -> ZLibMapInfo::Reader {
+        QByteArray data = m_archive.extract(*entry);
+        if (data.isNull()) {
+            return {};
+        }
+
+        return [data, pos = (qsizetype) 0](char *out, qint64 size) mutable -> qint64 {
+            qsizetype count = qMin<qsizetype>((qsizetype) size, data.size() - pos);
+            memcpy(out, data.constData() + pos, count);
+            pos += count;
+            return count;
+        };
+    };
+
+    //ZMAPINFO takes precedence over MAPINFO, includes are relative to the root of the archive
+    if (const SevenZipArchive::Entry *info = zmapinfo ? zmapinfo : mapinfo) {
+        auto resolve = [this, &open](const QString &name) -> ZLibMapInfo::Reader {
+            const SevenZipArchive::Entry *entry = m_archive.findEntry(name);
+            return entry ? open(entry) : ZLibMapInfo::Reader();
+        };
+
+        if (ZLibMapInfo::Reader reader = open(info)) {
+            map_names += ZLibMapInfo::getMapNames(reader, resolve, info->name);
+        }
+    }
+
+    return map_names;
+}
+
+QString ZLib7z::getIwadinfoName() {
+    for (const SevenZipArchive::Entry &entry: archive().entries()) {
+        if (!entry.isDirectory && entryPath(entry.name).isEmpty()
+            && !entryBaseName(entry.name).compare(QLatin1String("iwadinfo"), Qt::CaseInsensitive)) {
+            return parseIwadinfo(m_archive.extract(entry));
+        }
+    }
+
+    return {};
+}
+
+bool ZLib7z::isMAPXX() {
+    for (const SevenZipArchive::Entry &entry: archive().entries()) {
+        if (!entryPath(entry.name).compare(QLatin1String("maps"), Qt::CaseInsensitive)) {
+            QStringView file_name = entryFileName(entry.name);
+
+            if (!file_name.compare(QLatin1String("map01.wad"), Qt::CaseInsensitive)
+                || !file_name.compare(QLatin1String("map01.map"), Qt::CaseInsensitive)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
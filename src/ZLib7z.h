@@ -0,0 +1,104 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QStringList>
+#include <vector>
+#include "ZDLMapFile.h"
+
+// File list of a 7z archive, read from its headers alone. Headers may be
+// LZMA/LZMA2 compressed themselves; payload streams are left alone until
+// the contents of a specific (small) file are asked for.
+class SevenZipArchive {
+public:
+    struct Entry {
+        QString name;       // Always uses '/' as separator
+        qint64 size;
+        int folder;         // -1 for empty files and directories
+        qint64 folderOffset;
+        bool isDirectory;
+    };
+
+    // Returns false if file isn't a readable 7z archive
+    bool open(const QString &file);
+
+    [[nodiscard]] const std::vector<Entry> &entries() const {
+        return m_entries;
+    }
+
+    // Finds an entry by its full name, ignoring case
+    [[nodiscard]] const Entry *findEntry(const QString &name) const;
+
+    // Decodes a single entry. Only the part of its folder up to the end of
+    // the entry is decoded. Entries that would need more than maxSize bytes
+    // decoded, or use unsupported coders, yield a null array.
+    QByteArray extract(const Entry &entry, qint64 maxSize = 16 * 1024 * 1024);
+
+private:
+    struct Folder {
+        QByteArray method;
+        QByteArray properties;
+        qint64 packOffset;
+        qint64 packSize;
+        qint64 unpackSize;
+        int numSubstreams;
+        bool supported;
+    };
+
+    struct StreamsInfo {
+        std::vector<Folder> folders;
+        std::vector<qint64> streamSizes;
+    };
+
+    class HeaderReader;
+
+    bool readStreamsInfo(HeaderReader &reader, StreamsInfo &info);
+
+    bool readFilesInfo(HeaderReader &reader, const StreamsInfo &info);
+
+    QByteArray decode(const Folder &folder, qint64 size);
+
+    QFile zip;
+    std::vector<Entry> m_entries;
+    std::vector<Folder> folders;
+
+    // The last decoded folder prefix, MAPINFO includes tend to share a folder
+    int decodedFolder = -1;
+    QByteArray decodedData;
+};
+
+class ZLib7z : public ZDLMapFile {
+private:
+    SevenZipArchive &archive();
+
+    QString file;
+    SevenZipArchive m_archive;
+    bool m_opened = false;
+public:
+    explicit ZLib7z(QString file);
+
+    QString getIwadinfoName() override;
+
+    QStringList getMapNames() override;
+
+    bool isMAPXX() override;
+
+    ~ZLib7z() override;
+};
@@ -18,25 +18,93 @@
  */
 
 #include <QRegularExpression>
+#include <QThreadPool>
 #include <utility>
+#include <vector>
 #include "ZLibDir.h"
+#include "ZLibMapInfo.h"
 
-ZLibDir::ZLibDir(QString file) :
-        file(std::move(file)) {
+ZLibDir::ZLibDir(QString file, bool recursive, int concurrency) :
+        file(std::move(file)),
+        recursive(recursive),
+        concurrency(concurrency) {
 }
 
 ZLibDir::~ZLibDir()
 = default;
 
+namespace {
+    //Scanning is I/O bound, more threads than this mostly fight over the disk
+    const int default_concurrency = 4;
+
+    ZLibMapInfo::Reader openMapinfo(const QString &path) {
+        QSharedPointer<QFile> mapinfo_file(new QFile(path));
+
+        if (!mapinfo_file->open(QIODevice::ReadOnly)) {
+            return {};
+        }
+
+        return [mapinfo_file](char *data, qint64 size) {
+            return mapinfo_file->read(data, size);
+        };
+    }
+}
+
+QStringList ZLibDir::scanFiles() const {
+    QStringList files;
+    QStringList dirs(file);
+
+    //Breadth first, each directory in name order, so that the result doesn't depend on the file system
+    for (qsizetype i = 0; i < dirs.size(); i++) {
+        QDir zdir(dirs[i]);
+
+        for (const QFileInfo &zname: zdir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name)) {
+            files << zname.filePath();
+        }
+
+        if (recursive) {
+            for (const QFileInfo &zname: zdir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+                //Map lumps in maps/ are picked up by name below, don't probe them as archives
+                if (i || zname.fileName().compare("maps", Qt::CaseInsensitive)) {
+                    dirs << zname.filePath();
+                }
+            }
+        }
+    }
+
+    return files;
+}
+
 QStringList ZLibDir::getMapNames() {
     QDir zdir(file);
     QStringList map_names;
+    QStringList files = scanFiles();
+
+    int threads = concurrency > 0 ? concurrency : default_concurrency;
+    const QVector<Probe> probes = ZDLMapFile::probe(files, threads);
+
+    //Every file gets its own slot so the merge below keeps directory order
+    std::vector<QStringList> file_maps(files.size());
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
 
-    for (const QFileInfo &zname: zdir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot)) {
-        if (ZDLMapFile *mapfile = ZDLMapFile::getMapFile(zname.filePath())) {
-            map_names += mapfile->getMapNames();
-            delete mapfile;
+    for (qsizetype i = 0; i < probes.size(); i++) {
+        if (probes[i].type == Unknown) {
+            continue;
         }
+
+        pool.start([&probes, &file_maps, i]() {
+            if (ZDLMapFile *mapfile = probes[i].open()) {
+                file_maps[i] = mapfile->getMapNames();
+                delete mapfile;
+            }
+        });
+    }
+
+    pool.waitForDone();
+
+    for (const QStringList &maps: file_maps) {
+        map_names += maps;
     }
 
     if (zdir.cd("maps")) {    //CD is case insensitive
@@ -45,6 +113,27 @@ QStringList ZLibDir::getMapNames() {
         }
     }
 
+    zdir.setPath(file);
+    QStringList mapinfo_filter;
+    mapinfo_filter << "zmapinfo" << "zmapinfo.*" << "mapinfo" << "mapinfo.*"; //QDir::Filter is case insensitive by default
+    QFileInfoList mapinfo_list = zdir.entryInfoList(mapinfo_filter, QDir::Files | QDir::NoDotAndDotDot);
+
+    //ZMAPINFO takes precedence over MAPINFO
+    std::stable_sort(mapinfo_list.begin(), mapinfo_list.end(), [](const QFileInfo &a, const QFileInfo &b) {
+        return a.fileName().startsWith('z', Qt::CaseInsensitive) && !b.fileName().startsWith('z', Qt::CaseInsensitive);
+    });
+
+    if (mapinfo_list.length()) {
+        //Includes are relative to the root of the directory
+        auto resolve = [&zdir](const QString &name) {
+            return openMapinfo(zdir.filePath(name));
+        };
+
+        if (ZLibMapInfo::Reader reader = openMapinfo(mapinfo_list.first().filePath())) {
+            map_names += ZLibMapInfo::getMapNames(reader, resolve, mapinfo_list.first().fileName());
+        }
+    }
+
     return map_names;
 }
 
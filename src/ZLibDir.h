@@ -23,9 +23,15 @@
 
 class ZLibDir : public ZDLMapFile {
 private:
+    QStringList scanFiles() const;
+
     QString file;
+    bool recursive;
+    int concurrency;
 public:
-    explicit ZLibDir(QString file);
+    // Files of the directory (and of its subdirectories if recursive is set)
+    // are scanned on up to concurrency threads at once, 0 picks a default
+    explicit ZLibDir(QString file, bool recursive = false, int concurrency = 0);
 
     QString getIwadinfoName() override;
 
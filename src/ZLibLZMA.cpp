@@ -0,0 +1,499 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <vector>
+#include "ZLibLZMA.h"
+
+namespace {
+    const int input_size = 64 * 1024;
+
+    const int num_bit_model_bits = 11;
+    const quint16 bit_model_total = 1 << num_bit_model_bits;
+    const int num_move_bits = 5;
+    const quint32 top_value = 1 << 24;
+
+    const int num_states = 12;
+    const int max_pos_states = 16;
+    const int num_len_to_pos_states = 4;
+    const int num_align_bits = 4;
+    const int start_pos_model_index = 4;
+    const int end_pos_model_index = 14;
+    const int num_full_distances = 1 << (end_pos_model_index >> 1);
+    const int match_min_len = 2;
+
+    // Buffered byte source shared by consecutive LZMA2 chunks
+    class Input {
+    public:
+        explicit Input(const ZLibLZMA::Reader &reader) :
+                reader(reader),
+                buffer(input_size, Qt::Uninitialized) {
+        }
+
+        quint8 next() {
+            if (pos == end && !refill()) {
+                failed = true;
+                return 0;
+            }
+
+            consumed++;
+            return *pos++;
+        }
+
+        quint16 nextBE16() {
+            quint16 high = next();
+            return (quint16) ((high << 8) | next());
+        }
+
+        bool failed = false;
+        qint64 consumed = 0;
+
+    private:
+        bool refill() {
+            qint64 size = reader(buffer.data(), buffer.size());
+            if (size <= 0) {
+                return false;
+            }
+
+            pos = (const uchar *) buffer.constData();
+            end = pos + size;
+            return true;
+        }
+
+        const ZLibLZMA::Reader &reader;
+        QByteArray buffer;
+        const uchar *pos = nullptr;
+        const uchar *end = nullptr;
+    };
+
+    class RangeDecoder {
+    public:
+        explicit RangeDecoder(Input &input) :
+                input(input) {
+        }
+
+        bool init() {
+            range = 0xFFFFFFFF;
+            code = 0;
+
+            bool leading_zero = input.next() == 0;
+            for (int i = 0; i < 4; i++) {
+                code = (code << 8) | input.next();
+            }
+
+            return leading_zero && code != range && !input.failed;
+        }
+
+        unsigned bit(quint16 &prob) {
+            quint32 bound = (range >> num_bit_model_bits) * prob;
+            unsigned symbol;
+
+            if (code < bound) {
+                prob += (bit_model_total - prob) >> num_move_bits;
+                range = bound;
+                symbol = 0;
+            } else {
+                prob -= prob >> num_move_bits;
+                code -= bound;
+                range -= bound;
+                symbol = 1;
+            }
+
+            normalize();
+            return symbol;
+        }
+
+        quint32 direct(int count) {
+            quint32 result = 0;
+
+            while (count--) {
+                range >>= 1;
+                code -= range;
+                quint32 t = 0 - (code >> 31);
+                code += range & t;
+                result = (result << 1) + (t + 1);
+                normalize();
+            }
+
+            return result;
+        }
+
+        unsigned tree(quint16 *probs, int bits) {
+            unsigned m = 1;
+
+            for (int i = 0; i < bits; i++) {
+                m = (m << 1) + bit(probs[m]);
+            }
+
+            return m - (1u << bits);
+        }
+
+        unsigned reverseTree(quint16 *probs, int bits) {
+            unsigned m = 1;
+            unsigned symbol = 0;
+
+            for (int i = 0; i < bits; i++) {
+                unsigned b = bit(probs[m]);
+                m = (m << 1) + b;
+                symbol |= b << i;
+            }
+
+            return symbol;
+        }
+
+    private:
+        void normalize() {
+            if (range < top_value) {
+                range <<= 8;
+                code = (code << 8) | input.next();
+            }
+        }
+
+        Input &input;
+        quint32 range = 0;
+        quint32 code = 0;
+    };
+
+    struct LenDecoder {
+        quint16 choice;
+        quint16 choice2;
+        quint16 low[max_pos_states][1 << 3];
+        quint16 mid[max_pos_states][1 << 3];
+        quint16 high[1 << 8];
+
+        unsigned decode(RangeDecoder &rc, unsigned pos_state) {
+            if (!rc.bit(choice)) {
+                return rc.tree(low[pos_state], 3);
+            }
+
+            if (!rc.bit(choice2)) {
+                return 8 + rc.tree(mid[pos_state], 3);
+            }
+
+            return 16 + rc.tree(high, 8);
+        }
+    };
+
+    // Decoder state that survives between LZMA2 chunks. The output buffer
+    // holds everything decoded so far and serves as the dictionary.
+    class LzmaDecoder {
+    public:
+        explicit LzmaDecoder(QByteArray &out) :
+                out(out) {
+        }
+
+        bool setProperties(quint8 d) {
+            if (d >= 9 * 5 * 5) {
+                return false;
+            }
+
+            lc = d % 9;
+            d /= 9;
+            lp = d % 5;
+            pb = d / 5;
+            literals.resize((size_t) 0x300 << (lc + lp));
+            return true;
+        }
+
+        void reset() {
+            auto init = [](quint16 *probs, size_t count) {
+                std::fill(probs, probs + count, bit_model_total / 2);
+            };
+
+            init(literals.data(), literals.size());
+            init(&isMatch[0][0], sizeof(isMatch) / sizeof(quint16));
+            init(isRep, num_states);
+            init(isRepG0, num_states);
+            init(isRepG1, num_states);
+            init(isRepG2, num_states);
+            init(&isRep0Long[0][0], sizeof(isRep0Long) / sizeof(quint16));
+            init(&posSlot[0][0], sizeof(posSlot) / sizeof(quint16));
+            init(posDecoders, sizeof(posDecoders) / sizeof(quint16));
+            init(align, sizeof(align) / sizeof(quint16));
+            init((quint16 *) &lenDecoder, sizeof(lenDecoder) / sizeof(quint16));
+            init((quint16 *) &repLenDecoder, sizeof(repLenDecoder) / sizeof(quint16));
+
+            state = 0;
+            rep0 = rep1 = rep2 = rep3 = 0;
+        }
+
+        // Decodes until out holds end bytes or the end marker shows up
+        bool decode(RangeDecoder &rc, qint64 end) {
+            uchar *data = (uchar *) out.data();
+            unsigned pos_mask = (1u << pb) - 1;
+
+            while (pos < end) {
+                unsigned pos_state = pos & pos_mask;
+
+                if (!rc.bit(isMatch[state][pos_state])) {
+                    decodeLiteral(rc, data);
+                    continue;
+                }
+
+                unsigned len;
+                if (rc.bit(isRep[state])) {
+                    if (!pos) {
+                        return false;
+                    }
+
+                    if (!rc.bit(isRepG0[state])) {
+                        if (!rc.bit(isRep0Long[state][pos_state])) {
+                            state = state < 7 ? 9 : 11;
+                            data[pos] = data[pos - rep0 - 1];
+                            pos++;
+                            continue;
+                        }
+                    } else {
+                        quint32 dist;
+                        if (!rc.bit(isRepG1[state])) {
+                            dist = rep1;
+                        } else {
+                            if (!rc.bit(isRepG2[state])) {
+                                dist = rep2;
+                            } else {
+                                dist = rep3;
+                                rep3 = rep2;
+                            }
+
+                            rep2 = rep1;
+                        }
+
+                        rep1 = rep0;
+                        rep0 = dist;
+                    }
+
+                    len = repLenDecoder.decode(rc, pos_state);
+                    state = state < 7 ? 8 : 11;
+                } else {
+                    rep3 = rep2;
+                    rep2 = rep1;
+                    rep1 = rep0;
+                    len = lenDecoder.decode(rc, pos_state);
+                    state = state < 7 ? 7 : 10;
+                    rep0 = decodeDistance(rc, len);
+
+                    if (rep0 == 0xFFFFFFFF) {
+                        return true;    //End marker
+                    }
+                }
+
+                if (rep0 >= pos) {
+                    return false;
+                }
+
+                qint64 count = qMin<qint64>(len + match_min_len, end - pos);
+                const uchar *src = data + pos - rep0 - 1;
+
+                //Source and destination may overlap, copy byte by byte
+                for (qint64 i = 0; i < count; i++) {
+                    data[pos + i] = src[i];
+                }
+
+                pos += count;
+            }
+
+            return true;
+        }
+
+        // Appends raw bytes from an uncompressed LZMA2 chunk
+        bool copy(Input &input, qint64 size) {
+            uchar *data = (uchar *) out.data();
+
+            while (size--) {
+                data[pos++] = input.next();
+            }
+
+            return !input.failed;
+        }
+
+        qint64 pos = 0;
+
+    private:
+        void decodeLiteral(RangeDecoder &rc, uchar *data) {
+            unsigned prev_byte = pos ? data[pos - 1] : 0;
+            unsigned lit_state = ((pos & ((1u << lp) - 1)) << lc) + (prev_byte >> (8 - lc));
+            quint16 *probs = literals.data() + 0x300 * lit_state;
+            unsigned symbol = 1;
+
+            if (state >= 7 && pos > rep0) {
+                unsigned match_byte = data[pos - rep0 - 1];
+
+                do {
+                    unsigned match_bit = (match_byte >> 7) & 1;
+                    match_byte <<= 1;
+                    unsigned b = rc.bit(probs[((1 + match_bit) << 8) + symbol]);
+                    symbol = (symbol << 1) | b;
+
+                    if (match_bit != b) {
+                        break;
+                    }
+                } while (symbol < 0x100);
+            }
+
+            while (symbol < 0x100) {
+                symbol = (symbol << 1) | rc.bit(probs[symbol]);
+            }
+
+            data[pos++] = (uchar) (symbol - 0x100);
+            state = state < 4 ? 0 : (state < 10 ? state - 3 : state - 6);
+        }
+
+        quint32 decodeDistance(RangeDecoder &rc, unsigned len) {
+            unsigned len_state = qMin<unsigned>(len, num_len_to_pos_states - 1);
+            unsigned slot = rc.tree(posSlot[len_state], 6);
+
+            if (slot < start_pos_model_index) {
+                return slot;
+            }
+
+            int direct_bits = (int) (slot >> 1) - 1;
+            quint32 dist = (2 | (slot & 1)) << direct_bits;
+
+            if (slot < end_pos_model_index) {
+                return dist + rc.reverseTree(posDecoders + dist - slot, direct_bits);
+            }
+
+            dist += rc.direct(direct_bits - num_align_bits) << num_align_bits;
+            return dist + rc.reverseTree(align, num_align_bits);
+        }
+
+        QByteArray &out;
+        unsigned lc = 0;
+        unsigned lp = 0;
+        unsigned pb = 0;
+        unsigned state = 0;
+        quint32 rep0 = 0;
+        quint32 rep1 = 0;
+        quint32 rep2 = 0;
+        quint32 rep3 = 0;
+
+        std::vector<quint16> literals;
+        quint16 isMatch[num_states][max_pos_states];
+        quint16 isRep[num_states];
+        quint16 isRepG0[num_states];
+        quint16 isRepG1[num_states];
+        quint16 isRepG2[num_states];
+        quint16 isRep0Long[num_states][max_pos_states];
+        quint16 posSlot[num_len_to_pos_states][1 << 6];
+        quint16 posDecoders[1 + num_full_distances - end_pos_model_index];
+        quint16 align[1 << num_align_bits];
+        LenDecoder lenDecoder;
+        LenDecoder repLenDecoder;
+    };
+}
+
+QByteArray ZLibLZMA::decodeLzma(const QByteArray &properties, const Reader &reader, qint64 size) {
+    QByteArray out(size, Qt::Uninitialized);
+    Input input(reader);
+    RangeDecoder rc(input);
+    LzmaDecoder decoder(out);
+
+    if (properties.size() < 5 || !decoder.setProperties((quint8) properties[0])) {
+        return {};
+    }
+
+    decoder.reset();
+    if (!rc.init() || !decoder.decode(rc, size) || input.failed) {
+        return {};
+    }
+
+    out.truncate(decoder.pos);
+    return out;
+}
+
+QByteArray ZLibLZMA::decodeLzma2(const QByteArray &properties, const Reader &reader, qint64 size) {
+    QByteArray out(size, Qt::Uninitialized);
+    Input input(reader);
+    RangeDecoder rc(input);
+    LzmaDecoder decoder(out);
+    bool need_properties = true;
+
+    //Dictionary size is irrelevant, the whole output is the dictionary
+    if (properties.size() < 1 || (quint8) properties[0] > 40) {
+        return {};
+    }
+
+    while (decoder.pos < size) {
+        quint8 control = input.next();
+
+        if (input.failed) {
+            return {};
+        }
+
+        if (control == 0x00) {
+            break;    //End of stream
+        }
+
+        if (control == 0x01 || control == 0x02) {
+            qint64 chunk_size = input.nextBE16() + 1;
+            if (!decoder.copy(input, qMin(chunk_size, size - decoder.pos))) {
+                return {};
+            }
+
+            if (decoder.pos == size) {
+                break;
+            }
+
+            continue;
+        }
+
+        if (control < 0x80) {
+            return {};
+        }
+
+        qint64 unpacked = ((qint64) (control & 0x1F) << 16) + input.nextBE16() + 1;
+        qint64 packed = input.nextBE16() + 1;
+        int reset = (control >> 5) & 3;
+
+        if (reset >= 2) {
+            if (!decoder.setProperties(input.next())) {
+                return {};
+            }
+
+            need_properties = false;
+        } else if (need_properties) {
+            return {};
+        }
+
+        if (reset >= 1) {
+            decoder.reset();
+        }
+
+        qint64 start = input.consumed;
+        if (!rc.init() || !decoder.decode(rc, qMin(decoder.pos + unpacked, size)) || input.failed) {
+            return {};
+        }
+
+        qint64 used = input.consumed - start;
+        if (used > packed) {
+            return {};
+        }
+
+        //Ranges coders are flushed at chunk ends, skip whatever wasn't needed
+        while (used++ < packed) {
+            input.next();
+        }
+    }
+
+    if (input.failed) {
+        return {};
+    }
+
+    out.truncate(decoder.pos);
+    return out;
+}
@@ -0,0 +1,38 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <QByteArray>
+#include <functional>
+
+// Decoder for the raw LZMA and LZMA2 streams found in 7z archives. The whole
+// output is kept in memory and doubles as the dictionary, so it is only
+// meant for headers and small files.
+class ZLibLZMA {
+public:
+    // Fills data with up to size bytes of packed input, returns the number
+    // of bytes read, 0 at the end of input and -1 on error
+    using Reader = std::function<qint64(char *data, qint64 size)>;
+
+    // Decodes the first size bytes of an LZMA stream, properties being the
+    // 5 byte coder properties. Returns a null array on error.
+    static QByteArray decodeLzma(const QByteArray &properties, const Reader &reader, qint64 size);
+
+    // Same as decodeLzma for LZMA2, which has a single property byte
+    static QByteArray decodeLzma2(const QByteArray &properties, const Reader &reader, qint64 size);
+};
@@ -0,0 +1,226 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include "ZLibMapInfo.h"
+
+namespace {
+    const int chunk_size = 4096;
+    const int max_token = 256;
+    const int max_include_depth = 8;
+
+    enum LexState {
+        Blank,
+        Word,
+        Quoted,
+        QuotedEscape,
+        Slash,
+        LineComment,
+        BlockComment,
+        BlockCommentStar
+    };
+
+    enum Directive {
+        None,
+        Map,
+        Include
+    };
+
+    bool isBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+    }
+
+    // Characters that end a word and are tokens on their own
+    bool isPunctuation(char c) {
+        return c == '{' || c == '}' || c == '=' || c == ',';
+    }
+
+    bool equalsFolded(const char *token, int length, const char *lower) {
+        int i = 0;
+
+        for (; i < length && lower[i]; i++) {
+            char c = token[i];
+            if (c >= 'A' && c <= 'Z') {
+                c = (char) (c - 'A' + 'a');
+            }
+
+            if (c != lower[i]) {
+                return false;
+            }
+        }
+
+        return i == length && !lower[i];
+    }
+}
+
+ZLibMapInfo::Reader ZLibMapInfo::fromSpan(std::span<const char> data) {
+    return [data, pos = (size_t) 0](char *out, qint64 size) mutable -> qint64 {
+        size_t count = qMin((size_t) size, data.size() - pos);
+        memcpy(out, data.data() + pos, count);
+        pos += count;
+        return (qint64) count;
+    };
+}
+
+QStringList ZLibMapInfo::getMapNames(const Reader &reader, const Resolver &resolver, const QString &name) {
+    ZLibMapInfo mapinfo(resolver);
+    mapinfo.included.insert(name.toLower());
+    mapinfo.scan(reader, 0);
+    return mapinfo.mapNames;
+}
+
+void ZLibMapInfo::scan(const Reader &reader, int depth) {
+    char chunk[chunk_size];
+    char token[max_token];
+    int token_length = 0;
+    int tokens_on_line = 0;
+    int braces = 0;
+    LexState state = Blank;
+    Directive directive = None;
+
+    // Called for every complete word or quoted string. Only "map" and
+    // "include" at the start of a line outside of any block are of interest,
+    // this matches both old style MAPINFO and ZMAPINFO.
+    auto finish_token = [&]() {
+        if (directive == Map) {
+            QString name = QString::fromUtf8(token, qMin(token_length, 8)).toUpper();
+            if (!name.isEmpty()) {
+                mapNames << name;
+            }
+            directive = None;
+        } else if (directive == Include) {
+            QString name = QString::fromUtf8(token, token_length);
+            directive = None;
+
+            if (resolver && depth < max_include_depth && !included.contains(name.toLower())) {
+                included.insert(name.toLower());
+                if (Reader include = resolver(name)) {
+                    scan(include, depth + 1);
+                }
+            }
+        } else if (tokens_on_line == 0 && braces == 0) {
+            if (equalsFolded(token, token_length, "map")) {
+                directive = Map;
+            } else if (equalsFolded(token, token_length, "include")) {
+                directive = Include;
+            }
+        }
+
+        tokens_on_line++;
+        token_length = 0;
+    };
+
+    auto append = [&](char c) {
+        if (token_length < max_token) {
+            token[token_length++] = c;
+        }
+    };
+
+    qint64 length;
+    while ((length = reader(chunk, chunk_size)) > 0) {
+        for (qint64 i = 0; i < length; i++) {
+            char c = chunk[i];
+
+            // A slash only starts a comment if the next character says so,
+            // which may well be in the next chunk
+            if (state == Slash) {
+                if (c == '/' || c == '*') {
+                    if (token_length) {
+                        finish_token();
+                    }
+
+                    state = c == '/' ? LineComment : BlockComment;
+                    continue;
+                }
+
+                state = Word;
+                append('/');
+            }
+
+            switch (state) {
+                case LineComment:
+                    if (c == '\n') {
+                        state = Blank;
+                        tokens_on_line = 0;
+                    }
+                    continue;
+                case BlockComment:
+                case BlockCommentStar:
+                    if (c == '\n') {
+                        tokens_on_line = 0;
+                    }
+                    state = c == '*' ? BlockCommentStar : (state == BlockCommentStar && c == '/' ? Blank : BlockComment);
+                    continue;
+                case Quoted:
+                    if (c == '"') {
+                        finish_token();
+                        state = Blank;
+                    } else if (c == '\\') {
+                        state = QuotedEscape;
+                    } else {
+                        append(c);
+                    }
+                    continue;
+                case QuotedEscape:
+                    append(c);
+                    state = Quoted;
+                    continue;
+                default:
+                    break;
+            }
+
+            // Blank or Word from here on
+            if (isBlank(c) || isPunctuation(c) || c == '"' || c == ';' || c == '/') {
+                if (state == Word && c != '/') {
+                    finish_token();
+                    state = Blank;
+                }
+
+                if (c == '\n') {
+                    tokens_on_line = 0;
+                } else if (c == '"') {
+                    state = Quoted;
+                } else if (c == ';') {
+                    state = LineComment;
+                } else if (c == '/') {
+                    state = Slash;
+                } else if (c == '{') {
+                    braces++;
+                    tokens_on_line++;
+                } else if (c == '}') {
+                    braces = qMax(braces - 1, 0);
+                    tokens_on_line++;
+                } else if (isPunctuation(c)) {
+                    tokens_on_line++;
+                }
+            } else {
+                append(c);
+                state = Word;
+            }
+        }
+    }
+
+    if (state == Slash) {
+        append('/');
+        state = Word;
+    }
+
+    if (state == Word) {
+        finish_token();
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <QStringList>
+#include <QSet>
+#include <functional>
+#include <span>
+#include <utility>
+
+// Streaming scanner for MAPINFO and ZMAPINFO lumps. Input is pulled through
+// a reader in fixed-size chunks and run through a hand-written state machine,
+// so arbitrarily large MAPINFO trees are handled without loading them whole.
+class ZLibMapInfo {
+public:
+    // Fills data with up to size bytes, returns the number of bytes read,
+    // 0 at the end of input and -1 on error
+    using Reader = std::function<qint64(char *data, qint64 size)>;
+
+    // Opens the lump or file named by an include directive, returns an
+    // empty Reader if it doesn't exist
+    using Resolver = std::function<Reader(const QString &name)>;
+
+    // Names of all maps defined with a top level "map" directive, following
+    // "include" directives through resolver. name is the lump or file reader
+    // reads from, so that it won't be included again.
+    static QStringList getMapNames(const Reader &reader, const Resolver &resolver, const QString &name = {});
+
+    // Reader over a block of memory, such as a lump in a mapped WAD
+    static Reader fromSpan(std::span<const char> data);
+
+private:
+    explicit ZLibMapInfo(Resolver resolver) :
+            resolver(std::move(resolver)) {
+    }
+
+    void scan(const Reader &reader, int depth);
+
+    Resolver resolver;
+    QSet<QString> included;
+    QStringList mapNames;
+};
@@ -20,134 +20,704 @@
 #include <QRegularExpression>
 #include <utility>
 #include <QFileInfo>
+#include <QDateTime>
+#include <QMutex>
+#include <QHash>
+#include <cstring>
 #include "ZLibPK3.h"
+#include "ZLibMapInfo.h"
+#include "libwad.h"
 #include "miniz.h"
 
-ZLibPK3::ZLibPK3(QString file) :
-        file(std::move(file)) {
-}
+namespace {
+    struct CachedIndex {
+        qint64 size;
+        QDateTime modified;
+        QSharedPointer<const Pk3Index> index;
+    };
 
-ZLibPK3::~ZLibPK3()
-= default;
+    QMutex cache_mutex;
+    QHash<QString, CachedIndex> cache;
 
-QStringList ZLibPK3::getMapNames() {
-    mz_zip_archive zip_archive = {};
-    QStringList map_names;
+    QString parseIwadinfo(const QByteArray &iwadinfo) {
+        static QRegularExpression name_re("\\s+Name\\s*=\\s*\"(.+)\"\\s+");
+        QRegularExpressionMatch match = name_re.match(iwadinfo, Qt::CaseInsensitive);
 
-    if (mz_zip_reader_init_file(&zip_archive, qPrintable(file), 0)) {
-        if (mz_uint fnum = mz_zip_reader_get_num_files(&zip_archive)) {
-            mz_zip_archive_file_stat file_stat;
-            mz_uint mapinfo_idx{};
-            bool mapinfo = false;
-            bool zmapinfo = false;
-
-            for (mz_uint i = 0; i < fnum; i++) {
-                if (!mz_zip_reader_is_file_a_directory(&zip_archive, i)
-                    && mz_zip_reader_file_stat(&zip_archive, i, &file_stat)) {
-                    QFileInfo zname(file_stat.m_filename);
-                    if (!zname.path().compare("maps", Qt::CaseInsensitive)) {
-                        map_names << zname.baseName().left(8).toUpper();
-                    } else if (!zname.path().compare(".")) {
-                        if (!mapinfo && !zmapinfo && !zname.baseName().compare("mapinfo", Qt::CaseInsensitive)) {
-                            mapinfo = true;
-                            mapinfo_idx = i;
-                        } else if (!zmapinfo && !zname.baseName().compare("zmapinfo", Qt::CaseInsensitive)) {
-                            zmapinfo = true;
-                            mapinfo_idx = i;
-                        }
-                    }
+        if (match.hasPartialMatch())
+            return match.captured(1);
+
+        return {};
+    }
+
+    quint16 readLE16(const uchar *p) {
+        return (quint16) (p[0] | (p[1] << 8));
+    }
+
+    quint32 readLE32(const uchar *p) {
+        return (quint32) readLE16(p) | ((quint32) readLE16(p + 2) << 16);
+    }
+
+    quint64 readLE64(const uchar *p) {
+        return (quint64) readLE32(p) | ((quint64) readLE32(p + 4) << 32);
+    }
+
+    const quint32 eocd_sig = 0x06054b50;
+    const quint32 eocd64_locator_sig = 0x07064b50;
+    const quint32 eocd64_sig = 0x06064b50;
+    const quint32 cdh_sig = 0x02014b50;
+    const quint32 local_header_sig = 0x04034b50;
+
+    const int eocd_size = 22;
+    const int eocd64_locator_size = 20;
+    const int eocd64_size = 56;
+    const int cdh_size = 46;
+    const int local_header_size = 30;
+
+    const quint16 zip64_extra_id = 0x0001;
+    const quint32 dos_dir_attribute = 0x10;
+
+    const quint16 method_stored = 0;
+    const quint16 method_deflated = 8;
+
+    // Finds the central directory through the (ZIP64) end of central
+    // directory record. Returns false if the file isn't a ZIP archive.
+    bool locateCentralDirectory(QFile &zip, quint64 &cd_offset, quint64 &cd_size) {
+        qint64 size = zip.size();
+        if (size < eocd_size) {
+            return false;
+        }
+
+        //EOCD is at the very end, followed only by an up to 64k long comment
+        qint64 tail_size = qMin<qint64>(size, eocd_size + 0xFFFF + eocd64_locator_size);
+        if (!zip.seek(size - tail_size)) {
+            return false;
+        }
+
+        QByteArray tail = zip.read(tail_size);
+        if (tail.size() != tail_size) {
+            return false;
+        }
+
+        const auto *data = (const uchar *) tail.constData();
+        qint64 eocd = tail_size - eocd_size;
+        while (eocd >= 0 && readLE32(data + eocd) != eocd_sig) {
+            eocd--;
+        }
+
+        if (eocd < 0) {
+            return false;
+        }
+
+        cd_size = readLE32(data + eocd + 12);
+        cd_offset = readLE32(data + eocd + 16);
+
+        //An entry count of 0xFFFF may just be the real count, but a maxed out
+        //size or offset can only come from the ZIP64 record
+        bool needs_zip64 = cd_size == 0xFFFFFFFF || cd_offset == 0xFFFFFFFF;
+        if (needs_zip64 || readLE16(data + eocd + 10) == 0xFFFF) {
+            qint64 locator = eocd - eocd64_locator_size;
+            if (locator >= 0 && readLE32(data + locator) == eocd64_locator_sig) {
+                uchar eocd64[eocd64_size];
+                if (!zip.seek((qint64) readLE64(data + locator + 8))
+                    || zip.read((char *) eocd64, eocd64_size) != eocd64_size
+                    || readLE32(eocd64) != eocd64_sig) {
+                    return false;
                 }
+
+                cd_size = readLE64(eocd64 + 40);
+                cd_offset = readLE64(eocd64 + 48);
+            } else if (needs_zip64) {
+                return false;
             }
+        }
 
-            if (mapinfo || zmapinfo) {
-                size_t buf_len;
-                void *buf;
+        return cd_offset <= (quint64) size && cd_size <= (quint64) size - cd_offset;
+    }
 
-                if ((buf = mz_zip_reader_extract_to_heap(&zip_archive, mapinfo_idx, &buf_len, 0))) {
-                    QByteArray char_buf = QByteArray::fromRawData((const char *) buf, (qsizetype) buf_len);
+    // Checks that a maps/*.wad entry really holds a map, only touching the
+    // header and directory of the WAD. Deflated WADs are inflated just up to
+    // the end of the directory. The engine loads the map under the name of
+    // the entry, whatever the marker inside says, so the markers only serve
+    // to validate it. Entries that can't be read (say, compressed with a
+    // method we don't inflate) are given the benefit of the doubt.
+    bool isMapWad(QFile &zip, const ZipCentralDirectory::Entry &entry) {
+        ZipEntryReader reader(zip, entry);
+        if (!reader.isValid()) {
+            return true;
+        }
 
-                    for (const QString &str: QString(char_buf).split(QRegularExpression("[\r\n]"),
-                                                                     Qt::SkipEmptyParts)) {
-                        QRegularExpression name_re(R"(^\s*map\s+([^\s]+)(\s+.*)?$)");
-                        QRegularExpressionMatch match = name_re.match(str, Qt::CaseInsensitive);
+        WadDirectory::wadheader_t header{};
+        if (reader.read((char *) &header, sizeof(header)) != sizeof(header)
+            || (memcmp(header.type, "IWAD", 4) && memcmp(header.type, "PWAD", 4))
+            || header.numLumps <= 0 || header.directoryOffset < (int) sizeof(header)) {
+            return false;
+        }
 
-                        if (match.hasPartialMatch())
-                            map_names << match.captured(1).left(8).toUpper();
-                    }
+        quint64 directory_size = (quint64) header.numLumps * sizeof(WadDirectory::wadlump_t);
+        if ((quint64) header.directoryOffset + directory_size > entry.uncompressedSize) {
+            return false;
+        }
+
+        if (!reader.skip(header.directoryOffset - (qint64) sizeof(header))) {
+            return false;
+        }
+
+        //The lump count comes from the archive, so go through the directory
+        //a fixed number of entries at a time rather than reading it whole.
+        //Like WadDirectory, a map is a THINGS or TEXTMAP after its marker.
+        const int chunk_lumps = 256;
+        WadDirectory::wadlump_t lumps[chunk_lumps];
+        quint64 names[chunk_lumps];
+        quint8 tags[chunk_lumps];
+
+        for (int first = 0; first < header.numLumps; first += chunk_lumps) {
+            int count = qMin(chunk_lumps, header.numLumps - first);
+            qint64 size = count * (qint64) sizeof(WadDirectory::wadlump_t);
+            if (reader.read((char *) lumps, size) != size) {
+                return false;
+            }
+
+            for (int i = 0; i < count; i++) {
+                names[i] = WadDirectory::packName(lumps[i].name);
+            }
+            WadDirectory::classify(names, tags, count);
 
-                    mz_free(buf);
+            for (int i = first ? 0 : 1; i < count; i++) {
+                if (tags[i] == WadDirectory::Things || tags[i] == WadDirectory::Textmap) {
+                    return true;
                 }
             }
         }
 
-        mz_zip_reader_end(&zip_archive);
+        return false;
     }
+}
 
-    return map_names;
+bool ZipCentralDirectory::equalsFolded(std::string_view name, std::string_view lower) {
+    if (name.size() != lower.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < name.size(); i++) {
+        char c = name[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = (char) (c - 'A' + 'a');
+        }
+
+        if (c != lower[i]) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
-QString ZLibPK3::getIwadinfoName() {
-    mz_zip_archive zip_archive = {};
-    QString iwad_name;
-
-    if (mz_zip_reader_init_file(&zip_archive, qPrintable(file), 0)) {
-        if (mz_uint fnum = mz_zip_reader_get_num_files(&zip_archive)) {
-            mz_zip_archive_file_stat file_stat;
-
-            for (mz_uint i = 0; i < fnum; i++) {
-                if (!mz_zip_reader_is_file_a_directory(&zip_archive, i)
-                    && mz_zip_reader_file_stat(&zip_archive, i, &file_stat)) {
-                    QFileInfo zname(file_stat.m_filename);
-                    if (!zname.baseName().compare("iwadinfo", Qt::CaseInsensitive) && !zname.path().compare(".")) {
-                        size_t buf_len;
-                        void *buf;
-                        if ((buf = mz_zip_reader_extract_to_heap(&zip_archive, i, &buf_len, 0))) {
-                            QByteArray char_buf = QByteArray::fromRawData((const char *) buf, (qsizetype) buf_len);
-
-                            QRegularExpression name_re("\\s+Name\\s*=\\s*\"(.+)\"\\s+");
-                            QRegularExpressionMatch match = name_re.match(char_buf, Qt::CaseInsensitive);
-
-                            if (match.hasPartialMatch())
-                                iwad_name = match.captured(1);
-
-                            mz_free(buf);
-                        }
-                        break;
+bool ZipCentralDirectory::scan(const QString &file, const std::function<bool(const Entry &)> &filter) {
+    QFile zip(file);
+    quint64 cd_offset, cd_size;
+
+    if (!zip.open(QIODevice::ReadOnly) || !locateCentralDirectory(zip, cd_offset, cd_size)) {
+        return false;
+    }
+
+    //Map the directory if we can, fall back to a single read otherwise
+    QByteArray buffer;
+    const uchar *cd = cd_size ? zip.map((qint64) cd_offset, (qint64) cd_size) : nullptr;
+    if (!cd && cd_size) {
+        if (!zip.seek((qint64) cd_offset)) {
+            return false;
+        }
+
+        buffer = zip.read((qint64) cd_size);
+        if ((quint64) buffer.size() != cd_size) {
+            return false;
+        }
+
+        cd = (const uchar *) buffer.constData();
+    }
+
+    quint64 pos = 0;
+    while (pos + cdh_size <= cd_size && readLE32(cd + pos) == cdh_sig) {
+        const uchar *header = cd + pos;
+        quint16 name_length = readLE16(header + 28);
+        quint16 extra_length = readLE16(header + 30);
+        quint16 comment_length = readLE16(header + 32);
+
+        if (pos + cdh_size + name_length + extra_length + comment_length > cd_size) {
+            break;
+        }
+
+        Entry entry{};
+        entry.name = std::string_view((const char *) header + cdh_size, name_length);
+        entry.method = readLE16(header + 10);
+        entry.compressedSize = readLE32(header + 20);
+        entry.uncompressedSize = readLE32(header + 24);
+        entry.localHeaderOffset = readLE32(header + 42);
+        entry.isDirectory = (name_length && entry.name.back() == '/')
+                            || (readLE32(header + 38) & dos_dir_attribute) != 0;
+
+        //ZIP64 extra field holds, in order, only the values that overflowed in the header
+        const uchar *extra = header + cdh_size + name_length;
+        const uchar *extra_end = extra + extra_length;
+        while (extra + 4 <= extra_end) {
+            quint16 id = readLE16(extra);
+            quint16 size = readLE16(extra + 2);
+            const uchar *field = extra + 4;
+            const uchar *field_end = qMin(field + size, extra_end);
+
+            if (id == zip64_extra_id) {
+                for (quint64 *value: {&entry.uncompressedSize, &entry.compressedSize, &entry.localHeaderOffset}) {
+                    if (*value == 0xFFFFFFFF && field + 8 <= field_end) {
+                        *value = readLE64(field);
+                        field += 8;
                     }
                 }
             }
+
+            extra += 4 + size;
         }
 
-        mz_zip_reader_end(&zip_archive);
+        if (!filter(entry)) {
+            break;
+        }
+
+        pos += cdh_size + name_length + extra_length + comment_length;
+    }
+
+    if (buffer.isNull() && cd) {
+        zip.unmap((uchar *) cd);
     }
 
-    return iwad_name;
+    return true;
 }
 
-bool ZLibPK3::isMAPXX() {
-    mz_zip_archive zip_archive = {};
-    bool is_mapxx = false;
+qint64 ZipCentralDirectory::dataOffset(QFile &zip, const Entry &entry) {
+    uchar header[local_header_size];
 
-    if (mz_zip_reader_init_file(&zip_archive, qPrintable(file), 0)) {
-        if (mz_uint fnum = mz_zip_reader_get_num_files(&zip_archive)) {
-            mz_zip_archive_file_stat file_stat;
-
-            for (mz_uint i = 0; i < fnum; i++) {
-                if (!mz_zip_reader_is_file_a_directory(&zip_archive, i)
-                    && mz_zip_reader_file_stat(&zip_archive, i, &file_stat)) {
-                    QFileInfo zname(file_stat.m_filename);
-                    if (!zname.path().compare("maps", Qt::CaseInsensitive)
-                        && (!zname.fileName().compare("map01.wad", Qt::CaseInsensitive)
-                            || !zname.fileName().compare("map01.map", Qt::CaseInsensitive))) {
-                        is_mapxx = true;
-                        break;
-                    }
-                }
+    if (!zip.seek((qint64) entry.localHeaderOffset)
+        || zip.read((char *) header, local_header_size) != local_header_size
+        || readLE32(header) != local_header_sig) {
+        return -1;
+    }
+
+    return (qint64) entry.localHeaderOffset + local_header_size + readLE16(header + 26) + readLE16(header + 28);
+}
+
+QByteArray ZipCentralDirectory::extract(QFile &zip, const Entry &entry, qint64 maxSize) {
+    if (entry.uncompressedSize > (quint64) maxSize || entry.compressedSize > (quint64) maxSize
+        || (entry.method != method_stored && entry.method != method_deflated)) {
+        return {};
+    }
+
+    qint64 offset = dataOffset(zip, entry);
+    if (offset < 0 || !zip.seek(offset)) {
+        return {};
+    }
+
+    QByteArray compressed = zip.read((qint64) entry.compressedSize);
+    if ((quint64) compressed.size() != entry.compressedSize || entry.method == method_stored) {
+        return compressed;
+    }
+
+    QByteArray contents((qsizetype) entry.uncompressedSize, Qt::Uninitialized);
+    size_t written = tinfl_decompress_mem_to_mem(contents.data(), contents.size(),
+                                                 compressed.constData(), compressed.size(),
+                                                 TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+
+    if (written == TINFL_DECOMPRESS_MEM_TO_MEM_FAILED) {
+        return {};
+    }
+
+    contents.truncate((qsizetype) written);
+    return contents;
+}
+
+ZipEntryReader::ZipEntryReader(QFile &zip, const ZipCentralDirectory::Entry &entry) :
+        zip(zip),
+        position(ZipCentralDirectory::dataOffset(zip, entry)),
+        compressedLeft(entry.compressedSize),
+        method(entry.method),
+        valid(position >= 0 && (method == method_stored || method == method_deflated)) {
+    if (valid && method == method_deflated) {
+        inflator = tinfl_decompressor_alloc();
+        valid = inflator != nullptr;
+        input.resize(16 * 1024);
+        dictionary.resize(TINFL_LZ_DICT_SIZE);
+        inputPos = input.size();
+    }
+}
+
+ZipEntryReader::~ZipEntryReader() {
+    tinfl_decompressor_free(inflator);
+}
+
+bool ZipEntryReader::fillInput() {
+    qint64 size = (qint64) qMin<quint64>(compressedLeft, 16 * 1024);
+
+    if (!zip.seek(position) || zip.read(input.data(), size) != size) {
+        return false;
+    }
+
+    //Keep the unread part at the end of the buffer so inputPos stays meaningful
+    memmove(input.data() + input.size() - size, input.data(), size);
+    inputPos = input.size() - size;
+    position += size;
+    compressedLeft -= size;
+    return true;
+}
+
+qint64 ZipEntryReader::read(char *data, qint64 maxSize) {
+    if (!valid) {
+        return -1;
+    }
+
+    if (method == method_stored) {
+        qint64 size = (qint64) qMin<quint64>(compressedLeft, maxSize);
+
+        if (!zip.seek(position) || zip.read(data, size) != size) {
+            valid = false;
+            return -1;
+        }
+
+        position += size;
+        compressedLeft -= size;
+        return size;
+    }
+
+    qint64 total = 0;
+    while (total < maxSize) {
+        if (pendingPos < pendingEnd) {
+            qint64 size = qMin<qint64>(pendingEnd - pendingPos, maxSize - total);
+            memcpy(data + total, dictionary.constData() + pendingPos, size);
+            pendingPos += size;
+            total += size;
+            continue;
+        }
+
+        if (done) {
+            break;
+        }
+
+        if (inputPos == input.size() && compressedLeft && !fillInput()) {
+            valid = false;
+            return -1;
+        }
+
+        size_t in_size = input.size() - inputPos;
+        size_t out_size = dictionary.size() - dictionaryPos;
+        tinfl_status status = tinfl_decompress(inflator, (const mz_uint8 *) input.constData() + inputPos, &in_size,
+                                               (mz_uint8 *) dictionary.data(),
+                                               (mz_uint8 *) dictionary.data() + dictionaryPos, &out_size,
+                                               compressedLeft ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+
+        inputPos += (qsizetype) in_size;
+        pendingPos = dictionaryPos;
+        pendingEnd = dictionaryPos + (qsizetype) out_size;
+        dictionaryPos = (dictionaryPos + (qsizetype) out_size) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status == TINFL_STATUS_DONE) {
+            done = true;
+        } else if (status < TINFL_STATUS_DONE
+                   || (status == TINFL_STATUS_NEEDS_MORE_INPUT && !compressedLeft && inputPos == input.size())) {
+            valid = false;
+            return -1;
+        }
+    }
+
+    return total;
+}
+
+bool ZipEntryReader::skip(qint64 size) {
+    if (!valid || size < 0) {
+        return false;
+    }
+
+    if (method == method_stored) {
+        if ((quint64) size > compressedLeft) {
+            return false;
+        }
+
+        position += size;
+        compressedLeft -= size;
+        return true;
+    }
+
+    char scratch[4096];
+    while (size) {
+        qint64 read_size = read(scratch, qMin<qint64>(size, sizeof(scratch)));
+        if (read_size <= 0) {
+            return false;
+        }
+
+        size -= read_size;
+    }
+
+    return true;
+}
+
+QSharedPointer<const Pk3Index> Pk3Index::get(const QString &file) {
+    QFileInfo file_info(file);
+    QString key = file_info.absoluteFilePath();
+    qint64 size = file_info.size();
+    QDateTime modified = file_info.lastModified();
+
+    {
+        QMutexLocker locker(&cache_mutex);
+        auto it = cache.constFind(key);
+
+        if (it != cache.constEnd() && it->size == size && it->modified == modified) {
+            return it->index;
+        }
+    }
+
+    QSharedPointer<Pk3Index> index(new Pk3Index());
+    index->read(file);
+
+    QMutexLocker locker(&cache_mutex);
+    cache.insert(key, {size, modified, index});
+    return index;
+}
+
+QSharedPointer<const Pk3Index> Pk3Index::cached(const QString &file) {
+    QFileInfo file_info(file);
+    QMutexLocker locker(&cache_mutex);
+    auto it = cache.constFind(file_info.absoluteFilePath());
+
+    if (it != cache.constEnd() && it->size == file_info.size() && it->modified == file_info.lastModified()) {
+        return it->index;
+    }
+
+    return {};
+}
+
+void Pk3Index::read(const QString &file) {
+    ZipCentralDirectory::scan(file, [this](const ZipCentralDirectory::Entry &zip_entry) {
+        if (zip_entry.isDirectory || zip_entry.name.empty()) {
+            return true;
+        }
+
+        Entry entry{};
+        entry.name = (quint32) names.size();
+        entry.length = (quint16) zip_entry.name.size();
+        entry.method = zip_entry.method;
+        entry.localHeaderOffset = zip_entry.localHeaderOffset;
+        entry.compressedSize = zip_entry.compressedSize;
+        entry.uncompressedSize = zip_entry.uncompressedSize;
+
+        entry.base = entry.length;
+        while (entry.base && zip_entry.name[entry.base - 1] != '/') {
+            entry.base--;
+        }
+
+        size_t dot = zip_entry.name.find('.', entry.base);
+        entry.baseLength = (quint16) ((dot == std::string_view::npos ? entry.length : dot) - entry.base);
+
+        names.append(zip_entry.name.data(), (qsizetype) zip_entry.name.size());
+        entries.push_back(entry);
+        return true;
+    });
+
+    foldedNames = names.toLower();
+
+    //The first of duplicate names wins, same as a scan in order would
+    entryIndex.reserve((qsizetype) entries.size());
+    for (int i = 0; i < (int) entries.size(); i++) {
+        QByteArray name = folded(entries[i]);
+        if (!entryIndex.contains(name)) {
+            entryIndex.insert(name, i);
+        }
+    }
+
+    const Entry *mapinfo = nullptr;
+    const Entry *zmapinfo = nullptr;
+    const Entry *iwadinfo = nullptr;
+
+    for (const Entry &entry: entries) {
+        if (entry.base) {
+            continue;
+        }
+
+        QByteArray base_name = foldedBaseName(entry);
+        if (!mapinfo && base_name == "mapinfo") {
+            mapinfo = &entry;
+        } else if (!zmapinfo && base_name == "zmapinfo") {
+            zmapinfo = &entry;
+        } else if (!iwadinfo && base_name == "iwadinfo") {
+            iwadinfo = &entry;
+        }
+    }
+
+    std::vector<const Entry *> nested_wads;
+    for (const Entry &entry: entries) {
+        if (foldedPath(entry) == "maps" && foldedFileName(entry).endsWith(".wad")) {
+            nested_wads.push_back(&entry);
+        }
+    }
+
+    if (!mapinfo && !zmapinfo && !iwadinfo && nested_wads.empty()) {
+        return;
+    }
+
+    QFile zip(file);
+    if (!zip.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    for (const Entry *entry: nested_wads) {
+        if (!isMapWad(zip, zipEntry(*entry))) {
+            invalidMapWads.insert(entry->name);
+        }
+    }
+
+    //ZMAPINFO takes precedence over MAPINFO
+    if (const Entry *info = zmapinfo ? zmapinfo : mapinfo) {
+        auto open = [this, &zip](const Entry *entry) -> ZLibMapInfo::Reader {
+            QSharedPointer<ZipEntryReader> reader(new ZipEntryReader(zip, zipEntry(*entry)));
+            if (!reader->isValid()) {
+                return {};
             }
+
+            return [reader](char *data, qint64 size) {
+                return reader->read(data, size);
+            };
+        };
+
+        //Includes are relative to the root of the archive
+        auto resolve = [this, &open](const QString &name) -> ZLibMapInfo::Reader {
+            const Entry *entry = findEntry(name.toUtf8().toLower());
+            return entry ? open(entry) : ZLibMapInfo::Reader();
+        };
+
+        if (ZLibMapInfo::Reader reader = open(info)) {
+            mapinfoNames = ZLibMapInfo::getMapNames(reader, resolve,
+                                                    QString::fromUtf8(names.mid(info->name, info->length)));
         }
+    }
 
-        mz_zip_reader_end(&zip_archive);
+    if (iwadinfo) {
+        iwadinfoName = parseIwadinfo(ZipCentralDirectory::extract(zip, zipEntry(*iwadinfo)));
     }
+}
+
+ZipCentralDirectory::Entry Pk3Index::zipEntry(const Pk3Index::Entry &entry) const {
+    ZipCentralDirectory::Entry zip_entry{};
+    zip_entry.name = std::string_view(names.constData() + entry.name, entry.length);
+    zip_entry.localHeaderOffset = entry.localHeaderOffset;
+    zip_entry.compressedSize = entry.compressedSize;
+    zip_entry.uncompressedSize = entry.uncompressedSize;
+    zip_entry.method = entry.method;
+    return zip_entry;
+}
+
+const Pk3Index::Entry *Pk3Index::findEntry(const QByteArray &foldedName) const {
+    auto it = entryIndex.constFind(foldedName);
+    return it != entryIndex.constEnd() ? &entries[*it] : nullptr;
+}
+
+QByteArray Pk3Index::foldedPath(const Pk3Index::Entry &entry) const {
+    //Path without the trailing slash, same as QFileInfo::path() minus the "." for root entries
+    return QByteArray::fromRawData(foldedNames.constData() + entry.name, entry.base ? entry.base - 1 : 0);
+}
+
+QByteArray Pk3Index::foldedBaseName(const Pk3Index::Entry &entry) const {
+    return QByteArray::fromRawData(foldedNames.constData() + entry.name + entry.base, entry.baseLength);
+}
+
+QByteArray Pk3Index::foldedFileName(const Pk3Index::Entry &entry) const {
+    return QByteArray::fromRawData(foldedNames.constData() + entry.name + entry.base, entry.length - entry.base);
+}
+
+QStringList Pk3Index::getMapNames() const {
+    QStringList map_names;
+
+    for (const Entry &entry: entries) {
+        if (foldedPath(entry) == "maps" && !invalidMapWads.contains(entry.name)) {
+            map_names << QString::fromUtf8(names.constData() + entry.name + entry.base, entry.baseLength).left(8).toUpper();
+        }
+    }
+
+    map_names += mapinfoNames;
+    return map_names;
+}
+
+bool Pk3Index::isMAPXX() const {
+    for (const Entry &entry: entries) {
+        if (foldedPath(entry) == "maps") {
+            QByteArray file_name = foldedFileName(entry);
+
+            if (file_name == "map01.wad" || file_name == "map01.map") {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+ZLibPK3::ZLibPK3(QString file) :
+        file(std::move(file)) {
+}
+
+ZLibPK3::~ZLibPK3()
+= default;
+
+const Pk3Index &ZLibPK3::index() {
+    if (!m_index) {
+        m_index = Pk3Index::get(file);
+    }
+
+    return *m_index;
+}
+
+QStringList ZLibPK3::getMapNames() {
+    return index().getMapNames();
+}
+
+QString ZLibPK3::getIwadinfoName() {
+    if (m_index || (m_index = Pk3Index::cached(file))) {
+        return m_index->getIwadinfoName();
+    }
+
+    //Only IWADINFO is needed, so stop scanning as soon as it turns up
+    ZipCentralDirectory::Entry iwadinfo{};
+    bool found = false;
+
+    ZipCentralDirectory::scan(file, [&](const ZipCentralDirectory::Entry &entry) {
+        if (entry.isDirectory || entry.name.find('/') != std::string_view::npos) {
+            return true;
+        }
+
+        std::string_view base_name = entry.name.substr(0, entry.name.find('.'));
+        if (ZipCentralDirectory::equalsFolded(base_name, "iwadinfo")) {
+            iwadinfo = entry;
+            iwadinfo.name = {};    //Points into the directory buffer, which goes away with scan()
+            found = true;
+        }
+
+        return !found;
+    });
+
+    QFile zip(file);
+    if (found && zip.open(QIODevice::ReadOnly)) {
+        return parseIwadinfo(ZipCentralDirectory::extract(zip, iwadinfo));
+    }
+
+    return {};
+}
+
+bool ZLibPK3::isMAPXX() {
+    if (m_index || (m_index = Pk3Index::cached(file))) {
+        return m_index->isMAPXX();
+    }
+
+    bool is_mapxx = false;
+
+    ZipCentralDirectory::scan(file, [&](const ZipCentralDirectory::Entry &entry) {
+        is_mapxx = !entry.isDirectory
+                   && (ZipCentralDirectory::equalsFolded(entry.name, "maps/map01.wad")
+                       || ZipCentralDirectory::equalsFolded(entry.name, "maps/map01.map"));
+        return !is_mapxx;
+    });
 
     return is_mapxx;
 }
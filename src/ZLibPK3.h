@@ -18,11 +18,159 @@
  */
 #pragma once
 
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QStringList>
+#include <functional>
+#include <string_view>
+#include <vector>
 #include "ZDLMapFile.h"
 
+// Minimal reader for the central directory of a ZIP or ZIP64 archive.
+// The whole directory is read (or mapped) in one go and entries are handed
+// to a callback as views into that buffer, nothing is copied per entry.
+class ZipCentralDirectory {
+public:
+    struct Entry {
+        std::string_view name;    // Only valid for the duration of the callback
+        quint64 localHeaderOffset;
+        quint64 compressedSize;
+        quint64 uncompressedSize;
+        quint16 method;
+        bool isDirectory;
+    };
+
+    // Calls filter for every entry in directory order until it returns false.
+    // Returns false if file isn't a readable ZIP archive.
+    static bool scan(const QString &file, const std::function<bool(const Entry &)> &filter);
+
+    // Reads and inflates a single entry previously reported by scan.
+    // Entries larger than maxSize or using unsupported compression yield an
+    // empty array.
+    static QByteArray extract(QFile &zip, const Entry &entry, qint64 maxSize = 16 * 1024 * 1024);
+
+    // Offset of the entry's data, just past its local header, or -1
+    static qint64 dataOffset(QFile &zip, const Entry &entry);
+
+    // ASCII case-insensitive comparison against an all lowercase string
+    static bool equalsFolded(std::string_view name, std::string_view lower);
+};
+
+struct tinfl_decompressor_tag;
+
+// Streams the contents of a single stored or deflated entry, inflating only
+// as much as the caller asks for. Several readers may share one QFile.
+class ZipEntryReader {
+public:
+    ZipEntryReader(QFile &zip, const ZipCentralDirectory::Entry &entry);
+
+    ~ZipEntryReader();
+
+    ZipEntryReader(const ZipEntryReader &) = delete;
+
+    ZipEntryReader &operator=(const ZipEntryReader &) = delete;
+
+    [[nodiscard]] bool isValid() const {
+        return valid;
+    }
+
+    // Returns the number of bytes read, 0 at the end of the entry and -1 on error
+    qint64 read(char *data, qint64 maxSize);
+
+    // Moves size bytes forward, without inflating anything for stored entries
+    bool skip(qint64 size);
+
+private:
+    bool fillInput();
+
+    QFile &zip;
+    qint64 position;
+    quint64 compressedLeft;
+    quint16 method;
+    bool valid;
+    bool done = false;
+
+    tinfl_decompressor_tag *inflator = nullptr;
+    QByteArray input;
+    qsizetype inputPos = 0;
+    QByteArray dictionary;
+    qsizetype dictionaryPos = 0;
+    qsizetype pendingPos = 0;
+    qsizetype pendingEnd = 0;
+};
+
+// Everything ZDL needs to know about a PK3, gathered from a single pass over
+// its central directory. Entry names live in one arena (plus a case-folded
+// copy of it) and each entry only stores offsets into it.
+class Pk3Index {
+public:
+    // Returns the cached index for file, rebuilding it if the file's path,
+    // modification time or size changed. Never returns null, an unreadable
+    // archive yields an empty index.
+    static QSharedPointer<const Pk3Index> get(const QString &file);
+
+    // Returns the cached index for file if it is still up to date, null otherwise
+    static QSharedPointer<const Pk3Index> cached(const QString &file);
+
+    [[nodiscard]] QStringList getMapNames() const;
+
+    [[nodiscard]] QString getIwadinfoName() const {
+        return iwadinfoName;
+    }
+
+    [[nodiscard]] bool isMAPXX() const;
+
+private:
+    struct Entry {
+        quint32 name;       // Offset of the full name in the arena
+        quint16 length;     // Length of the full name
+        quint16 base;       // Offset of the file name from the start of the full name
+        quint16 baseLength; // Length of the file name up to its first dot
+        quint16 method;
+        quint64 localHeaderOffset;
+        quint64 compressedSize;
+        quint64 uncompressedSize;
+    };
+
+    [[nodiscard]] ZipCentralDirectory::Entry zipEntry(const Entry &entry) const;
+
+    // Finds an entry by its full, case-folded name
+    [[nodiscard]] const Entry *findEntry(const QByteArray &foldedName) const;
+
+    Pk3Index() = default;
+
+    void read(const QString &file);
+
+    [[nodiscard]] QByteArray folded(const Entry &entry) const {
+        return QByteArray::fromRawData(foldedNames.constData() + entry.name, entry.length);
+    }
+
+    [[nodiscard]] QByteArray foldedPath(const Entry &entry) const;
+
+    [[nodiscard]] QByteArray foldedBaseName(const Entry &entry) const;
+
+    [[nodiscard]] QByteArray foldedFileName(const Entry &entry) const;
+
+    QByteArray names;
+    QByteArray foldedNames;
+    std::vector<Entry> entries;
+    // Case-folded full names, pointing into foldedNames, to entries
+    QHash<QByteArray, int> entryIndex;
+    QStringList mapinfoNames;
+    // Arena offsets of maps/*.wad entries that hold no map
+    QSet<quint32> invalidMapWads;
+    QString iwadinfoName;
+};
+
 class ZLibPK3 : public ZDLMapFile {
 private:
+    const Pk3Index &index();
+
     QString file;
+    QSharedPointer<const Pk3Index> m_index;
 public:
     explicit ZLibPK3(QString file);
 
@@ -19,111 +19,341 @@
  */
 
 #include <QRegularExpression>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMutex>
+#include <QHash>
 #include <utility>
-#include <fstream>
+#include <cstring>
 #include "libwad.h"
+#include "ZLibMapInfo.h"
 
-DoomWad::DoomWad(QString file) :
-        m_file(std::move(file)) {
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WAD_CLASSIFY_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    struct CachedDirectory {
+        qint64 size;
+        QDateTime modified;
+        QSharedPointer<const WadDirectory> directory;
+    };
+
+    QMutex cache_mutex;
+    QHash<QString, CachedDirectory> cache;
+
+    const char *const tag_names[WadDirectory::NumTags] = {
+            "",
+            "THINGS",
+            "LINEDEFS",
+            "SIDEDEFS",
+            "VERTEXES",
+            "SEGS",
+            "SSECTORS",
+            "NODES",
+            "SECTORS",
+            "REJECT",
+            "BLOCKMAP",
+            "BEHAVIOR",
+            "TEXTMAP",
+            "ENDMAP",
+            "IWADINFO",
+            "MAPINFO",
+            "ZMAPINFO"
+    };
+
+    quint8 classifyOne(quint64 name, const quint64 *markers) {
+        for (quint8 tag = WadDirectory::Things; tag < WadDirectory::NumTags; tag++) {
+            if (name == markers[tag]) {
+                return tag;
+            }
+        }
+
+        return WadDirectory::Other;
+    }
 }
 
-DoomWad::~DoomWad()
-= default;
+quint64 WadDirectory::packName(const char *name) {
+    char padded[8] = {};
 
-QStringList DoomWad::getMapNames() {
-    QStringList map_names;
-    std::ifstream wadStream(m_file.toUtf8().constData(), std::ios::binary);
+    for (int i = 0; i < 8 && name[i]; i++) {
+        padded[i] = name[i];
+    }
 
-    if (!wadStream) {
-        return map_names;
+    quint64 packed;
+    memcpy(&packed, padded, sizeof(packed));
+    return packed;
+}
+
+void WadDirectory::classify(const quint64 *names, quint8 *tags, size_t count) {
+    quint64 markers[NumTags];
+    for (int tag = 0; tag < NumTags; tag++) {
+        markers[tag] = packName(tag_names[tag]);
+    }
+
+    size_t i = 0;
+
+    // Each name is a single 64-bit word, so a vector compare against a
+    // broadcast marker tests several lumps at once. Lanes that match get the
+    // marker's tag OR'ed in; names are unique per marker, so at most one
+    // marker can match any given lane.
+#if defined(__AVX2__)
+    for (; i + 4 <= count; i += 4) {
+        __m256i block = _mm256_loadu_si256((const __m256i *) (names + i));
+        __m256i result = _mm256_setzero_si256();
+
+        for (int tag = Things; tag < NumTags; tag++) {
+            __m256i eq = _mm256_cmpeq_epi64(block, _mm256_set1_epi64x((long long) markers[tag]));
+            result = _mm256_or_si256(result, _mm256_and_si256(eq, _mm256_set1_epi64x(tag)));
+        }
+
+        alignas(32) quint64 lanes[4];
+        _mm256_store_si256((__m256i *) lanes, result);
+        for (int lane = 0; lane < 4; lane++) {
+            tags[i + lane] = (quint8) lanes[lane];
+        }
+    }
+#elif defined(WAD_CLASSIFY_SSE2)
+    for (; i + 2 <= count; i += 2) {
+        __m128i block = _mm_loadu_si128((const __m128i *) (names + i));
+        __m128i result = _mm_setzero_si128();
+
+        for (int tag = Things; tag < NumTags; tag++) {
+            // SSE2 has no 64-bit compare: both 32-bit halves of a lane have to match
+            __m128i eq = _mm_cmpeq_epi32(block, _mm_set1_epi64x((long long) markers[tag]));
+            eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+            result = _mm_or_si128(result, _mm_and_si128(eq, _mm_set1_epi64x(tag)));
+        }
+
+        alignas(16) quint64 lanes[2];
+        _mm_store_si128((__m128i *) lanes, result);
+        tags[i] = (quint8) lanes[0];
+        tags[i + 1] = (quint8) lanes[1];
+    }
+#endif
+
+    for (; i < count; i++) {
+        tags[i] = classifyOne(names[i], markers);
+    }
+}
+
+QSharedPointer<const WadDirectory> WadDirectory::get(const QString &file) {
+    QFileInfo file_info(file);
+    QString key = file_info.absoluteFilePath();
+    qint64 size = file_info.size();
+    QDateTime modified = file_info.lastModified();
+
+    {
+        QMutexLocker locker(&cache_mutex);
+        auto it = cache.constFind(key);
+
+        if (it != cache.constEnd() && it->size == size && it->modified == modified) {
+            return it->directory;
+        }
+    }
+
+    QSharedPointer<WadDirectory> directory(new WadDirectory());
+    directory->read(WadMapping(file));
+
+    QMutexLocker locker(&cache_mutex);
+    cache.insert(key, {size, modified, directory});
+    return directory;
+}
+
+WadMapping::WadMapping(const QString &file) :
+        file(file) {
+    if (this->file.open(QIODevice::ReadOnly) && this->file.size() > 0) {
+        length = this->file.size();
+        base = (const char *) this->file.map(0, length);
+
+        if (!base) {
+            length = 0;
+        }
+    }
+}
+
+WadMapping::~WadMapping() {
+    if (base) {
+        file.unmap((uchar *) base);
+    }
+}
+
+std::span<const char> WadMapping::range(qint64 offset, qint64 size) const {
+    if (offset < 0 || size < 0 || offset > length || size > length - offset) {
+        return {};
+    }
+
+    return {base + offset, (size_t) size};
+}
+
+std::span<const char> WadMapping::lump(const WadDirectory &directory, int index) const {
+    if (index < 0 || index >= directory.size()) {
+        return {};
+    }
+
+    return range(directory.lumpOffset(index), directory.lumpSize(index));
+}
+
+void WadDirectory::read(const WadMapping &wad) {
+    std::span<const char> header_data = wad.range(0, sizeof(wadheader_t));
+
+    if (header_data.empty()) {
+        return;
     }
 
     wadheader_t header{};
-    wadStream.read((char *) &header, sizeof(header));
+    memcpy(&header, header_data.data(), sizeof(header));
+
+    if (header.numLumps <= 0) {
+        return;
+    }
+
+    std::span<const char> lumps = wad.range(header.directoryOffset, (qint64) header.numLumps * sizeof(wadlump_t));
+
+    if (lumps.empty()) {
+        return;
+    }
+
+    readEntries(lumps);
+
+    std::span<const char> iwadinfo = wad.lump(*this, findTag(Iwadinfo));
+    if (!iwadinfo.empty()) {
+        static QRegularExpression name_re("\\s+Name\\s*=\\s*\"(.+)\"\\s+");
+        QRegularExpressionMatch match = name_re.match(
+                QByteArray::fromRawData(iwadinfo.data(), (qsizetype) iwadinfo.size()), Qt::CaseInsensitive);
+
+        if (match.hasPartialMatch()) {
+            iwadinfoName = match.captured(1);
+        }
+    }
+
+    //ZMAPINFO takes precedence over MAPINFO, includes name other lumps of the same WAD
+    int mapinfo = findTag(ZMapinfo) >= 0 ? findTag(ZMapinfo) : findTag(Mapinfo);
+    if (mapinfo >= 0) {
+        auto resolve = [this, &wad](const QString &name) -> ZLibMapInfo::Reader {
+            int lump = findLump(name.toUpper().toLatin1().left(8).constData());
+            return lump >= 0 ? ZLibMapInfo::fromSpan(wad.lump(*this, lump)) : ZLibMapInfo::Reader();
+        };
+
+        mapinfoNames = ZLibMapInfo::getMapNames(ZLibMapInfo::fromSpan(wad.lump(*this, mapinfo)), resolve,
+                                                lumpName(mapinfo));
+    }
+}
+
+void WadDirectory::readEntries(std::span<const char> entries) {
+    size_t count = entries.size() / sizeof(wadlump_t);
+    names.reserve(count);
+    offsets.reserve(count);
+    sizes.reserve(count);
 
-    std::vector<wadlump_t> lumps(header.numLumps);
-    wadStream.seekg(header.directoryOffset);
-    wadStream.read((char *) lumps.data(), (long) (header.numLumps * sizeof(wadlump_t)));
+    // Directory entries aren't guaranteed to be aligned inside the mapping
+    for (size_t pos = 0; pos + sizeof(wadlump_t) <= entries.size(); pos += sizeof(wadlump_t)) {
+        wadlump_t lump;
+        memcpy(&lump, entries.data() + pos, sizeof(lump));
+        names.push_back(packName(lump.name));
+        offsets.push_back(lump.offset);
+        sizes.push_back(lump.length);
+    }
+
+    index();
+}
+
+void WadDirectory::index() {
+    tags.resize(names.size());
+    classify(names.data(), tags.data(), names.size());
 
     // Generally the WAD structure follows a simple layout,
     // and we can assume that it will hold for most WADs.
     // In most cases map lumps follow the pattern:
     // MAPNAME
-    // THINGS
+    // THINGS (or TEXTMAP for UDMF maps)
     // ...
-    // so we take the first lump name preceding THINGS
-    const char *previous = nullptr;
-    for (const wadlump_t &lump: lumps) {
-        if (strcmp("THINGS", lump.name) == 0 && previous != nullptr) {
-            map_names << previous;
+    // so we take the lump name preceding THINGS or TEXTMAP
+    for (size_t i = 1; i < tags.size(); i++) {
+        if (tags[i] == Things || tags[i] == Textmap) {
+            maps.push_back((int) i - 1);
         }
+    }
+}
 
-        previous = lump.name;
+int WadDirectory::findTag(LumpTag tag) const {
+    for (size_t i = 0; i < tags.size(); i++) {
+        if (tags[i] == tag) {
+            return (int) i;
+        }
     }
 
-    wadStream.close();
-    return map_names;
+    return -1;
 }
 
-QString DoomWad::getIwadinfoName() {
-    QString iwadInfoName;
-    std::ifstream wadStream(m_file.toUtf8().constData(), std::ios::binary);
+int WadDirectory::findLump(const char *name) const {
+    return findLump(packName(name));
+}
 
-    if (!wadStream) {
-        return iwadInfoName;
+int WadDirectory::findLump(quint64 packed) const {
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == packed) {
+            return (int) i;
+        }
     }
 
-    wadheader_t header{};
-    wadStream.read((char *) &header, sizeof(header));
+    return -1;
+}
 
-    std::vector<wadlump_t> lumps(header.numLumps);
-    wadStream.seekg(header.directoryOffset);
-    wadStream.read((char *) lumps.data(), (long) (header.numLumps * sizeof(wadlump_t)));
+QString WadDirectory::lumpName(int index) const {
+    const char *name = (const char *) &names[index];
+    return QString::fromLatin1(name, (qsizetype) strnlen(name, 8));
+}
 
-    for (const wadlump_t &lump: lumps) {
-        if (strcmp("IWADINFO", lump.name) == 0) {
-            char *iwadinfo = new char[lump.length];
-            wadStream.seekg(lump.offset);
-            wadStream.read(iwadinfo, lump.length);
+QStringList WadDirectory::getMapNames() const {
+    QStringList map_names;
 
-            static QRegularExpression name_re("\\s+Name\\s*=\\s*\"(.+)\"\\s+");
-            QRegularExpressionMatch match = name_re.match(iwadinfo, Qt::CaseInsensitive);
+    for (int map: maps) {
+        map_names << lumpName(map);
+    }
 
-            if (match.hasPartialMatch()) {
-                iwadInfoName = match.captured(1);
-            }
+    map_names += mapinfoNames;
+    return map_names;
+}
 
-            delete[] iwadinfo;
-            break;
-        }
-    }
+bool WadDirectory::isMAPXX() const {
+    return findLump("MAP01") >= 0;
+}
 
-    wadStream.close();
-    return iwadInfoName;
+DoomWad::DoomWad(QString file) :
+        m_file(std::move(file)) {
 }
 
-bool DoomWad::isMAPXX() {
-    bool isMapxx = false;
-    std::ifstream wadStream(m_file.toUtf8().constData(), std::ios::binary);
+DoomWad::~DoomWad()
+= default;
 
-    if (!wadStream) {
-        return isMapxx;
+const WadDirectory &DoomWad::directory() {
+    if (!m_directory) {
+        m_directory = WadDirectory::get(m_file);
     }
 
-    wadheader_t header{};
-    wadStream.read((char *) &header, sizeof(header));
-
-    std::vector<wadlump_t> lumps(header.numLumps);
-    wadStream.seekg(header.directoryOffset);
-    wadStream.read((char *) lumps.data(), (long) (header.numLumps * sizeof(wadlump_t)));
+    return *m_directory;
+}
 
-    for (const wadlump_t &lump: lumps) {
-        if (strcmp("MAP01", lump.name) == 0) {
-            isMapxx = true;
-            break;
-        }
+std::span<const char> DoomWad::lump(const char *name) {
+    if (!m_mapping) {
+        m_mapping.reset(new WadMapping(m_file));
     }
 
-    wadStream.close();
-    return isMapxx;
+    return m_mapping->lump(directory(), directory().findLump(name));
+}
+
+QStringList DoomWad::getMapNames() {
+    return directory().getMapNames();
+}
+
+QString DoomWad::getIwadinfoName() {
+    return directory().getIwadinfoName();
+}
+
+bool DoomWad::isMAPXX() {
+    return directory().isMAPXX();
 }
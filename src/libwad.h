@@ -20,10 +20,52 @@
 #pragma once
 
 #include <QString>
+#include <QFile>
+#include <QSharedPointer>
+#include <QScopedPointer>
+#include <span>
+#include <vector>
 #include "ZDLMapFile.h"
 
-class DoomWad : public ZDLMapFile {
+class WadDirectory;
+
+// Read-only memory mapping of a whole WAD file. Lumps are handed out as
+// spans pointing straight into the mapping and stay valid for as long as
+// the WadMapping is alive.
+class WadMapping {
+public:
+    explicit WadMapping(const QString &file);
+
+    ~WadMapping();
+
+    WadMapping(const WadMapping &) = delete;
+
+    WadMapping &operator=(const WadMapping &) = delete;
+
+    [[nodiscard]] bool isValid() const {
+        return base != nullptr;
+    }
+
+    [[nodiscard]] std::span<const char> data() const {
+        return {base, (size_t) length};
+    }
+
+    // Returns an empty span if the range falls outside the file
+    [[nodiscard]] std::span<const char> range(qint64 offset, qint64 size) const;
+
+    [[nodiscard]] std::span<const char> lump(const WadDirectory &directory, int index) const;
+
 private:
+    QFile file;
+    const char *base = nullptr;
+    qint64 length = 0;
+};
+
+// Lump directory of a single WAD file, read once and shared by every query
+// made against that file. Names, offsets and sizes are kept in separate
+// arrays so that scans over names touch as little memory as possible.
+class WadDirectory {
+public:
     struct wadheader_t {
         [[maybe_unused]] char type[4];
         int numLumps;
@@ -36,10 +78,105 @@ private:
         char name[8];
     };
 
+    // Lumps that have a meaning for map detection, everything else is Other
+    enum LumpTag : quint8 {
+        Other,
+        Things,
+        Linedefs,
+        Sidedefs,
+        Vertexes,
+        Segs,
+        SSectors,
+        Nodes,
+        Sectors,
+        Reject,
+        Blockmap,
+        Behavior,
+        Textmap,
+        Endmap,
+        Iwadinfo,
+        Mapinfo,
+        ZMapinfo,
+        NumTags
+    };
+
+    // Returns the cached directory for file, (re)reading it if the file
+    // changed on disk since the last call. Never returns null, a file that
+    // can't be read yields an empty directory.
+    static QSharedPointer<const WadDirectory> get(const QString &file);
+
+    [[nodiscard]] int size() const {
+        return (int) names.size();
+    }
+
+    [[nodiscard]] int findLump(const char *name) const;
+
+    [[nodiscard]] int findLump(quint64 packed) const;
+
+    [[nodiscard]] QString lumpName(int index) const;
+
+    [[nodiscard]] qint32 lumpOffset(int index) const {
+        return offsets[index];
+    }
+
+    [[nodiscard]] qint32 lumpSize(int index) const {
+        return sizes[index];
+    }
+
+    [[nodiscard]] LumpTag lumpTag(int index) const {
+        return (LumpTag) tags[index];
+    }
+
+    // Index of the first lump with the given tag, or -1
+    [[nodiscard]] int findTag(LumpTag tag) const;
+
+    [[nodiscard]] QStringList getMapNames() const;
+
+    [[nodiscard]] bool isMAPXX() const;
+
+    [[nodiscard]] QString getIwadinfoName() const {
+        return iwadinfoName;
+    }
+
+    // Packs an up to 8 character lump name into a single comparable word,
+    // everything after the first NUL is zeroed
+    static quint64 packName(const char *name);
+
+    // Fills tags[i] with the LumpTag of names[i]
+    static void classify(const quint64 *names, quint8 *tags, size_t count);
+
+private:
+    WadDirectory() = default;
+
+    void read(const WadMapping &wad);
+
+    void readEntries(std::span<const char> entries);
+
+    void index();
+
+    std::vector<quint64> names;
+    std::vector<qint32> offsets;
+    std::vector<qint32> sizes;
+    std::vector<quint8> tags;
+    std::vector<int> maps;
+    QStringList mapinfoNames;
+    QString iwadinfoName;
+};
+
+class DoomWad : public ZDLMapFile {
+private:
+    const WadDirectory &directory();
+
     QString m_file;
+    QSharedPointer<const WadDirectory> m_directory;
+    QScopedPointer<WadMapping> m_mapping;
 public:
     explicit DoomWad(QString file);
 
+    // Contents of the named lump, mapping the file on first use.
+    // Empty if the lump doesn't exist or the file can't be mapped.
+    std::span<const char> lump(const char *name);
+
     QString getIwadinfoName() override;
 
     QStringList getMapNames() override;
@@ -21,6 +21,8 @@
 #include "ZDLNullDevice.h"
 #include "ZDLConfigurationManager.h"
 #include "ZDLMainWindow.h"
+#include "ZDLFingerprint.h"
+#include "ZDLMetaCache.h"
 
 #if defined(_WIN32)
 #include "windows.h"
@@ -29,43 +31,23 @@
 ZDLMainWindow *mw;
 
 void clearFiles(ZDLConf *zconf) {
-    ZDLSection *section = zconf->getSection("zdl.save");
-    if (section) {
-        QVector<ZDLLine *> vctr;
-        section->getRegex("^file[0-9]+d?$", vctr);
-
-        for (auto &i: vctr) {
-            zconf->deleteValue("zdl.save", i->getVariable());
-        }
-    }
+    //Duplicate lines included, which the numbered index only holds the first of
+    zconf->deleteRegex("zdl.save", "^file[0-9]+d?$");
 }
 
 void addFile(const QString &file, ZDLConf *zconf) {
     LOGDATA() << "Adding " << file << " to " << (void *) zconf << Qt::endl;
-    ZDLSection *section = zconf->getSection("zdl.save");
+    const ZDLSection *section = zconf->getSection("zdl.save");
     if (!section) {
         zconf->setValue("zdl.save", "file0", file);
         return;
     }
-    QVector<ZDLLine *> vctr;
-    section->getRegex("^file[0-9]+$", vctr);
-    if (vctr.empty()) {
+    ZDLSection::IndexedList files = section->list("file");
+    if (files.empty()) {
         zconf->setValue("zdl.save", "file0", file);
         return;
     }
-    QVector<int> numbers;
-    for (auto &i: vctr) {
-        bool ok = false;
-        QString value = i->getVariable();
-        value.remove(0, 4);
-        int val = value.toInt(&ok);
-        if (!ok) {
-            return;
-        }
-        numbers.push_back(val);
-    }
-    std::sort(numbers.begin(), numbers.end());
-    int highest = numbers.last();
+    int highest = files.last().index;
     zconf->setValue("zdl.save", "file" + QString::number(highest + 1), file);
 }
 
@@ -200,7 +182,7 @@ int main(int argc, char **argv) {
             tconf->deleteSectionByName("zdl.save");
             ZDLConf zdlFile;
             zdlFile.readINI(item);
-            ZDLSection *section = zdlFile.getSection("zdl.save");
+            const ZDLSection *section = zdlFile.getSection("zdl.save");
             if (section) {
                 tconf->addSection(section->clone());
                 hasZDLFile = true;
@@ -277,6 +259,8 @@ int main(int argc, char **argv) {
     }
 
     tconf->writeINI(ZDLConfigurationManager::getConfigFileName());
+    ZDLFingerprint::shutdown();
+    ZDLMetaCache::getInstance()->save();
     LOGDATA() << "ZDL QUIT" << Qt::endl;
     return ret;
 }
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <QtCore>
+#include <atomic>
 
 #define ZDL_FLAG_NAMELESS    0x00001
 
@@ -74,20 +75,27 @@ extern QDebug *zdlDebug;
 #endif
 
 #else
-#define LOGDATA() (*zdlDebug)
-#define LOGDATAO() (*zdlDebug)
+//Without the logger everything goes to a null device anyway. Skip the
+//formatting, and with it the shared stream that readers on other threads
+//would otherwise all write to.
+#define LOGDATA() while (false) (*zdlDebug)
+#define LOGDATAO() while (false) (*zdlDebug)
 #define DPTR(ptr) QString("")
 #endif
 
-#define LOCK_CLASS               QRecursiveMutex
-#define LOCK_BUILDER()           new QRecursiveMutex()
-#define GET_READLOCK(mlock)      (mlock)->lock()
-#define RELEASE_READLOCK(mlock)  (mlock)->unlock()
-#define GET_WRITELOCK(mlock)     (mlock)->lock()
-#define RELEASE_WRITELOCK(mlock) (mlock)->unlock()
-#define TRY_READLOCK(mlock, to)  (mlock)->tryLock(to)
-#define TRY_WRITELOCK(mlock, to) (mlock)->tryLock(to)
+//Readers share the lock, writers get it to themselves. Locks aren't
+//recursive, which saves tracking the owning threads: a thread must not take
+//a lock it already holds, in either mode. They're held by value in what
+//they guard and only allocate anything while contended.
+#define LOCK_CLASS               QReadWriteLock
+#define GET_READLOCK(mlock)      (mlock).lockForRead()
+#define RELEASE_READLOCK(mlock)  (mlock).unlock()
+#define GET_WRITELOCK(mlock)     (mlock).lockForWrite()
+#define RELEASE_WRITELOCK(mlock) (mlock).unlock()
+#define TRY_READLOCK(mlock, to)  (mlock).tryLockForRead(to)
+#define TRY_WRITELOCK(mlock, to) (mlock).tryLockForWrite(to)
 
+#include "zdlpool.hpp"
 #include "zdlline.hpp"
 #include "zdlsection.hpp"
 #include "zdlconf.hpp"
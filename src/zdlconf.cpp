@@ -27,20 +27,64 @@
  *            config files can be written back with keys it doesn't know how to use.
  *      Date: July 29th, 2007
  */
+#include <QSaveFile>
 #include "zdlcommon.h"
 
+namespace {
+    //Walks a whole file in one pass, handing out trimmed views of its
+    //non-empty lines. The views point into the buffer, the only copy made
+    //of a line is the one ZDLLine keeps.
+    class ZDLIniTokenizer {
+    public:
+        explicit ZDLIniTokenizer(QStringView buffer) : rest(buffer) {}
+
+        bool next(QStringView &line) {
+            while (!rest.isEmpty()) {
+                qsizetype end = rest.indexOf(u'\n');
+                if (end < 0) {
+                    end = rest.size();
+                }
+
+                line = rest.left(end).trimmed();
+                rest = rest.mid(qMin(end + 1, rest.size()));
+                if (!line.isEmpty()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        QStringView rest;
+    };
+
+    QString readBuffer(QFile &stream) {
+        //Map the file where we can, to decode it without another copy
+        qint64 size = stream.size();
+        if (uchar *data = size > 0 ? stream.map(0, size) : nullptr) {
+            QString buffer = QString::fromUtf8(reinterpret_cast<const char *>(data), (int) size);
+            stream.unmap(data);
+            return buffer;
+        }
+        return QString::fromUtf8(stream.readAll());
+    }
+}
+
 int ZDLConf::readINI(const QString &file) {
     LOGDATAO() << "Reading file " << file << Qt::endl;
     if ((mode & ZDLConf::FileRead) != 0) {
         writeLock();
         reads++;
+        //Only a configuration that holds nothing but the file matches it
+        bool fresh = sections.empty();
+        savedFile.clear();
         /* We allow lines to be outside of any section (ie header comments)
          * We use a global section to read this.  We also keep track of
          * which section we're in.  We do that with a pointer (current)
          */
         auto *current = new ZDLSection("");
         current->setSpecial(ZDL_FLAG_NAMELESS);
-        sections.push_back(current);
+        insertSection(current);
         QFile stream(file);
         stream.open(QIODevice::ReadOnly);
         if (!stream.isOpen()) {
@@ -48,14 +92,20 @@ int ZDLConf::readINI(const QString &file) {
             releaseWriteLock();
             return 1;
         }
-        while (!stream.atEnd()) {
-            QByteArray array = stream.readLine();
-            QString line(array);
-            parse(line, current);
-            current = sections.back();
-        }
+        QString buffer = readBuffer(stream);
         stream.close();
 
+        ZDLIniTokenizer tokenizer(buffer);
+        QStringView line;
+        while (tokenizer.next(line)) {
+            current = parse(line, current);
+        }
+
+        if (fresh) {
+            savedFile = file;
+            savedGeneration = currentGeneration();
+        }
+
         QFileInfo info(file);
         if (!info.isWritable()) {
             LOGDATAO() << "File is unwriteable, writes will be ignored" << Qt::endl;
@@ -73,8 +123,21 @@ int ZDLConf::writeINI(const QString &file) {
     setValue("zdl.general", "conflib", "sunrise");
     LOGDATAO() << "Writing file to " << file << Qt::endl;
     if ((mode & ZDLConf::FileWrite) != 0) {
+        readLock();
+        quint64 writeGeneration = currentGeneration();
+        if (file == savedFile && writeGeneration == savedGeneration && QFileInfo::exists(file)) {
+            LOGDATAO() << "Nothing changed since the file was last read or written" << Qt::endl;
+            releaseReadLock();
+            return 0;
+        }
+        QByteArray buffer = serialize().toUtf8();
+        releaseReadLock();
+
         writes++;
-        QFile stream(file);
+        //Written to a temporary file and renamed over the old one, so that
+        //a crash half way through leaves the previous file in place
+        QSaveFile stream(file);
+        stream.setDirectWriteFallback(true);
         stream.open(QIODevice::WriteOnly);
         if (!stream.isOpen()) {
             QFileInfo fi(file);
@@ -91,9 +154,16 @@ int ZDLConf::writeINI(const QString &file) {
                 return 1;
             }
         }
-        QIODevice *dev = &stream;
-        writeStream(dev);
-        stream.close();
+        stream.write(buffer);
+        if (!stream.commit()) {
+            LOGDATAO() << "Cannot save file" << Qt::endl;
+            return 1;
+        }
+
+        writeLock();
+        savedFile = file;
+        savedGeneration = writeGeneration;
+        releaseWriteLock();
         return 0;
     } else {
         LOGDATAO() << "Cannot write file, no permission" << Qt::endl;
@@ -104,10 +174,9 @@ int ZDLConf::writeINI(const QString &file) {
 int ZDLConf::writeStream(QIODevice *stream) {
     if ((mode & ZDLConf::FileWrite) != 0) {
         readLock();
-        for (auto &section: sections) {
-            section->streamWrite(stream);
-        }
+        QByteArray buffer = serialize().toUtf8();
         releaseReadLock();
+        stream->write(buffer);
         return 0;
     } else {
         return 1;
@@ -119,7 +188,8 @@ ZDLConf::ZDLConf(int mode) {
     this->mode = mode;
     reads = 0;
     writes = 0;
-    mutex = LOCK_BUILDER();
+    generation = ZDLSection::nextGeneration();
+    savedGeneration = 0;
 }
 
 int ZDLConf::reopen(int imode) {
@@ -136,22 +206,19 @@ ZDLConf::~ZDLConf() {
         sections.pop_front();
         delete section;
     }
+    sectionIndex.clear();
     releaseWriteLock();
-    delete mutex;
 }
 
 void ZDLConf::deleteSection(const QString &lsection) {
     LOGDATAO() << "Deleting section " << lsection << Qt::endl;
     writeLock();
-    for (int i = 0; i < sections.size(); i++) {
-        ZDLSection *section = sections[i];
-        QString secName = section->getName();
-        if (secName == lsection) {
-            LOGDATAO() << "Found and removed" << Qt::endl;
-            sections.remove(i);
-            releaseWriteLock();
-            return;
-        }
+    if (ZDLSection *section = findExactSection(lsection)) {
+        LOGDATAO() << "Found and removed" << Qt::endl;
+        removeSection(section);
+        releaseWriteLock();
+        delete section;
+        return;
     }
     releaseWriteLock();
     LOGDATAO() << "No such section" << Qt::endl;
@@ -162,14 +229,11 @@ void ZDLConf::deleteValue(const QString &lsection, const QString &variable) {
     writeLock();
     if ((mode & WriteOnly) != 0) {
         writes++;
-        for (auto section: sections) {
-            if (section->getName().compare(lsection, Qt::CaseInsensitive) == 0) {
-                LOGDATAO() << "Found section" << Qt::endl;
-                section->deleteVariable(variable);
-                releaseWriteLock();
-                return;
-            }
-
+        if (ZDLSection *section = findSection(lsection)) {
+            LOGDATAO() << "Found section" << Qt::endl;
+            section->deleteVariable(variable);
+            releaseWriteLock();
+            return;
         }
     }
     releaseWriteLock();
@@ -180,11 +244,12 @@ QString ZDLConf::getValue(const QString &lsection, const QString &variable, int
     if ((mode & ReadOnly) != 0) {
         readLock();
         reads++;
-        ZDLSection *sect = getSection(lsection);
+        ZDLSection *sect = findSection(lsection);
         if (sect) {
             *status = 0;
+            QString value = sect->findVariable(variable);
             releaseReadLock();
-            return sect->findVariable(variable);
+            return value;
         }
         *status = 1;
         releaseReadLock();
@@ -199,10 +264,11 @@ QString ZDLConf::getValue(const QString &lsection, const QString &variable) {
     if ((mode & ReadOnly) != 0) {
         readLock();
         reads++;
-        ZDLSection *sect = getSection(lsection);
+        ZDLSection *sect = findSection(lsection);
         if (sect) {
+            QString value = sect->findVariable(variable);
             releaseReadLock();
-            return sect->findVariable(variable);
+            return value;
         }
         releaseReadLock();
     }
@@ -210,18 +276,14 @@ QString ZDLConf::getValue(const QString &lsection, const QString &variable) {
     return {};
 }
 
-ZDLSection *ZDLConf::getSection(const QString &lsection) {
+const ZDLSection *ZDLConf::getSection(const QString &lsection) {
     LOGDATAO() << "getting section " << lsection << Qt::endl;
     if ((mode & ReadOnly) != 0) {
         readLock();
-        for (auto section: sections) {
-            if (section->getName().compare(lsection, Qt::CaseInsensitive) == 0) {
-                LOGDATAO() << "Got it " << DPTR(section) << Qt::endl;
-                releaseReadLock();
-                ZDLSection *copy = section->clone();
-                copy->setIsCopy(true);
-                return copy;
-            }
+        if (ZDLSection *section = findSection(lsection)) {
+            LOGDATAO() << "Got it " << DPTR(section) << Qt::endl;
+            releaseReadLock();
+            return section;
         }
         releaseReadLock();
     }
@@ -234,12 +296,10 @@ int ZDLConf::hasValue(const QString &lsection, const QString &variable) {
     if ((mode & ReadOnly) != 0) {
         reads++;
         readLock();
-        for (auto section: sections) {
-            if (section->getName().compare(lsection, Qt::CaseInsensitive) == 0) {
-                releaseReadLock();
-                return section->hasVariable(variable);
-            }
-
+        if (ZDLSection *section = findSection(lsection)) {
+            int rc = section->hasVariable(variable);
+            releaseReadLock();
+            return rc;
         }
         releaseReadLock();
     }
@@ -259,59 +319,49 @@ void ZDLConf::setValue(const QString &lsection, const QString &variable, const Q
 
     const QString &value = szBuffer;
 
-    //Better handing of variables.  Don't overwrite if you don't have to.
     writeLock();
-    if (hasValue(lsection, variable)) {
-        int stat;
-        QString oldValue = getValue(lsection, variable, &stat);
-        if (oldValue == szBuffer) {
+    if (ZDLSection *section = findSection(lsection)) {
+        //Better handing of variables.  Don't overwrite if you don't have to.
+        if (section->hasVariable(variable) && section->findVariable(variable) == szBuffer) {
             LOGDATAO() << "No difference between set and previous variable" << Qt::endl;
             releaseWriteLock();
             return;
         }
-    }
 
-    writes++;
-    for (auto section: sections) {
-        if (section->getName().compare(lsection, Qt::CaseInsensitive) == 0) {
-            section->setValue(variable, value);
-            LOGDATAO() << "Asked section to set variable" << Qt::endl;
-            releaseWriteLock();
-            return;
-        }
+        writes++;
+        section->setValue(variable, value);
+        LOGDATAO() << "Asked section to set variable" << Qt::endl;
+        releaseWriteLock();
+        return;
     }
 
+    writes++;
     LOGDATAO() << "No such section, creating" << Qt::endl;
     //In this case, we didn't find the section
     auto *section = new ZDLSection(lsection);
-    sections.push_back(section);
+    insertSection(section);
     section->setValue(variable, value);
     releaseWriteLock();
 }
 
-void ZDLConf::parse(QString in, ZDLSection *current) {
-    if (in.length() < 1) {
-        return;
-    }
-
-    in = in.trimmed();
-
+ZDLSection *ZDLConf::parse(QStringView in, ZDLSection *current) {
     LOGDATAO() << "Parse " << in << Qt::endl;
-    if (in.size() > 0
-        && in[0] == '['
-        && in[in.length() - 1] == ']') {
-        in = in.mid(1, in.length() - 2);
+    if (in.size() >= 2
+        && in.front() == u'['
+        && in.back() == u']') {
+        QString name = in.mid(1, in.size() - 2).toString();
         //This will remove duplicate sections automagically
-        ZDLSection *ptr = getSection(in);
+        ZDLSection *ptr = findSection(name);
         if (ptr == nullptr) {
-            current = new ZDLSection(in);
-            sections.push_back(current);
+            current = new ZDLSection(name);
+            insertSection(current);
         } else {
             current = ptr;
         }
     } else {
         current->addLine(in);
     }
+    return current;
 }
 
 ZDLConf *ZDLConf::clone() {
@@ -329,14 +379,12 @@ ZDLConf *ZDLConf::clone() {
 void ZDLConf::deleteSectionByName(const QString &section) {
     LOGDATAO() << "Deleting section " << section << Qt::endl;
     writeLock();
-    for (int i = 0; i < sections.size(); i++) {
-        if (sections[i]->getName().compare(section) == 0) {
-            ZDLSection *sect = sections[i];
-            sections.remove(i);
-            LOGDATAO() << "Deleted section" << Qt::endl;
-            releaseWriteLock();
-            delete sect;
-        }
+    if (ZDLSection *sect = findExactSection(section)) {
+        removeSection(sect);
+        LOGDATAO() << "Deleted section" << Qt::endl;
+        releaseWriteLock();
+        delete sect;
+        return;
     }
     releaseWriteLock();
     LOGDATAO() << "No such section" << Qt::endl;
@@ -344,11 +392,10 @@ void ZDLConf::deleteSectionByName(const QString &section) {
 
 int ZDLConf::getFlagsForValue(const QString &lsection, const QString &var) {
     readLock();
-    for (auto section: sections) {
-        if (section->getName().compare(lsection, Qt::CaseInsensitive) == 0) {
-            releaseReadLock();
-            return section->getFlagsForValue(var);
-        }
+    if (ZDLSection *section = findSection(lsection)) {
+        int rc = section->getFlagsForValue(var);
+        releaseReadLock();
+        return rc;
     }
     releaseReadLock();
     return -1;
@@ -356,11 +403,10 @@ int ZDLConf::getFlagsForValue(const QString &lsection, const QString &var) {
 
 bool ZDLConf::setFlagsForValue(const QString &lsection, const QString &var, int value) {
     readLock();
-    for (auto section: sections) {
-        if (section->getName().compare(lsection, Qt::CaseInsensitive) == 0) {
-            releaseReadLock();
-            return section->setFlagsForValue(var, value);
-        }
+    if (ZDLSection *section = findSection(lsection)) {
+        bool rc = section->setFlagsForValue(var, value);
+        releaseReadLock();
+        return rc;
     }
     releaseReadLock();
     return false;
@@ -368,15 +414,91 @@ bool ZDLConf::setFlagsForValue(const QString &lsection, const QString &var, int
 
 bool ZDLConf::deleteRegex(const QString &lsection, const QString &regex) {
     readLock();
-    for (auto section: sections) {
-        if (section->getName().compare(lsection, Qt::CaseInsensitive) == 0) {
-            bool rc = section->deleteRegex(regex);
-            releaseReadLock();
-            return rc;
-        }
+    if (ZDLSection *section = findSection(lsection)) {
+        bool rc = section->deleteRegex(regex);
+        releaseReadLock();
+        return rc;
     }
     releaseReadLock();
     return false;
 }
 
+void ZDLConf::addSection(ZDLSection *section) {
+    writeLock();
+    insertSection(section);
+    releaseWriteLock();
+}
+
+QString ZDLConf::sectionKey(const QString &name) {
+    return name.toCaseFolded();
+}
+
+ZDLSection *ZDLConf::findSection(const QString &name) const {
+    return sectionIndex.value(sectionKey(name), nullptr);
+}
 
+ZDLSection *ZDLConf::findExactSection(const QString &name) const {
+    ZDLSection *first = findSection(name);
+    if (!first || first->getName() == name) {
+        return first;
+    }
+
+    //The index only holds the first of the duplicates, look for the others
+    for (auto section: sections) {
+        if (section->getName() == name) {
+            return section;
+        }
+    }
+    return nullptr;
+}
+
+QString ZDLConf::serialize() {
+    qsizetype size = 0;
+    for (auto &section: sections) {
+        size += section->streamSize();
+    }
+
+    QString buffer;
+    buffer.reserve(size);
+    for (auto &section: sections) {
+        section->streamWrite(buffer);
+    }
+    return buffer;
+}
+
+quint64 ZDLConf::currentGeneration() const {
+    quint64 latest = generation;
+    for (auto &section: sections) {
+        latest = qMax(latest, section->getGeneration());
+    }
+    return latest;
+}
+
+void ZDLConf::insertSection(ZDLSection *section) {
+    sections.push_back(section);
+    generation = ZDLSection::nextGeneration();
+
+    //Like a scan in file order would, lookups find the first of duplicates
+    QString key = sectionKey(section->getName());
+    if (!sectionIndex.contains(key)) {
+        sectionIndex.insert(key, section);
+    }
+}
+
+void ZDLConf::removeSection(ZDLSection *section) {
+    sections.removeOne(section);
+    generation = ZDLSection::nextGeneration();
+
+    QString key = sectionKey(section->getName());
+    if (sectionIndex.value(key) != section) {
+        return;
+    }
+
+    sectionIndex.remove(key);
+    for (auto other: sections) {
+        if (sectionKey(other->getName()) == key) {
+            sectionIndex.insert(key, other);
+            break;
+        }
+    }
+}
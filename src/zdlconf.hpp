@@ -56,11 +56,16 @@ public:
 
     int reopen(int imode);
 
+    // In file order. Read only, go through addSection and deleteSection* to
+    // change it so that the index stays in sync.
     QVector<ZDLSection *> sections;
 
     int writeStream(QIODevice *stream);
 
-    ZDLSection *getSection(const QString &section);
+    // The live section, owned by the configuration. It stays valid until
+    // the section is deleted or the configuration destroyed, so don't hold
+    // on to it across either.
+    const ZDLSection *getSection(const QString &section);
 
     void deleteSection(const QString &section);
 
@@ -68,9 +73,7 @@ public:
 
     void deleteSectionByName(const QString &section);
 
-    void addSection(ZDLSection *section) {
-        sections.push_back(section);
-    }
+    void addSection(ZDLSection *section);
 
     int getFlagsForValue(const QString &section, const QString &var);
 
@@ -111,10 +114,40 @@ protected:
 
 private:
     int mode;
-    int reads;
-    int writes;
+    std::atomic<int> reads;
+    std::atomic<int> writes;
+
+    // Handles one trimmed, non-empty line of a file and returns the section
+    // the lines after it belong to
+    ZDLSection *parse(QStringView in, ZDLSection *current);
+
+    static QString sectionKey(const QString &name);
+
+    // Section called name, compared case-insensitively. These expect the
+    // lock to be held.
+    ZDLSection *findSection(const QString &name) const;
+
+    // Section called exactly name, even if one differing only in case comes first
+    ZDLSection *findExactSection(const QString &name) const;
+
+    void insertSection(ZDLSection *section);
+
+    void removeSection(ZDLSection *section);
+
+    // The file as writeINI would write it. These expect the lock to be held.
+    QString serialize();
+
+    // Latest generation of the configuration and its sections
+    quint64 currentGeneration() const;
+
+    quint64 generation;
+
+    // The file the configuration last matched, and when it did
+    QString savedFile;
+    quint64 savedGeneration;
 
-    void parse(QString in, ZDLSection *current);
+    // Case folded section names to sections
+    QHash<QString, ZDLSection *> sectionIndex;
 
-    LOCK_CLASS *mutex;
+    LOCK_CLASS mutex;
 };
@@ -21,24 +21,21 @@
 #include "zdlcommon.h"
 #include "zdlline.hpp"
 
-ZDLLine::ZDLLine(const QString &inLine) {
+ZDLLine::ZDLLine(QStringView inLine) {
     flags = FLAG_NORMAL;
-    line = inLine.trimmed();
-    comment = "";
-    if (line[0] == ';' || line[0] == '#') {
+    line = inLine.trimmed().toString();
+    commentBegin = (int) line.size();
+    if (line.startsWith(';') || line.startsWith('#')) {
         type = 2;
     } else {
         type = 0;
         parse();
     }
+    updateQtLine();
     isCopy = false;
 }
 
 ZDLLine::ZDLLine() {
-    line = "";
-    comment = "";
-    value = "";
-    variable = "";
     type = 2;
     isCopy = false;
 }
@@ -46,20 +43,74 @@ ZDLLine::ZDLLine() {
 ZDLLine::~ZDLLine()
 = default;
 
+void *ZDLLine::operator new(std::size_t size) {
+    if (size > ZDLNodePool::lines().blockSize()) {
+        return ::operator new(size);
+    }
+    return ZDLNodePool::lines().allocate();
+}
+
+void ZDLLine::operator delete(void *block, std::size_t size) {
+    if (size > ZDLNodePool::lines().blockSize()) {
+        ::operator delete(block);
+        return;
+    }
+    ZDLNodePool::lines().release(block);
+}
+
 void ZDLLine::setIsCopy(bool val) {
     isCopy = val;
 }
 
-QString ZDLLine::getValue() {
-    return QFD_QT_SEP(value);
+QString ZDLLine::getValue() const {
+    return getValueView().toString();
+}
+
+QString ZDLLine::getVariable() const {
+    return getVariableView().toString();
+}
+
+QString ZDLLine::getLine() const {
+#ifdef _WIN32
+    if (!qtSepLine.isNull()) {
+        return qtSepLine;
+    }
+#endif
+    return line;
 }
 
-QString ZDLLine::getVariable() {
-    return QFD_QT_SEP(variable);
+QStringView ZDLLine::getValueView() const {
+    return qtLine().mid(valueBegin, valueSize);
 }
 
-QString ZDLLine::getLine() {
-    return QFD_QT_SEP(line);
+QStringView ZDLLine::getVariableView() const {
+    return qtLine().left(variableSize);
+}
+
+QStringView ZDLLine::getLineView() const {
+    return qtLine();
+}
+
+QStringView ZDLLine::qtLine() const {
+#ifdef _WIN32
+    if (!qtSepLine.isNull()) {
+        return qtSepLine;
+    }
+#endif
+    return line;
+}
+
+void ZDLLine::updateQtLine() {
+#ifdef _WIN32
+    //Converting separators keeps every character in place, so the ranges
+    //apply to both. Done up front rather than on first read, as readers
+    //share the section lock.
+    if (line.contains('\\')) {
+        qtSepLine = QFD_QT_SEP(line);
+    } else {
+        qtSepLine.clear();
+    }
+#endif
 }
 
 void ZDLLine::setValue(const QString &inValue) {
@@ -67,17 +118,31 @@ void ZDLLine::setValue(const QString &inValue) {
         qDebug() << "SETTING A VALUE ON A COPY" << Qt::endl;
     }
     // Don't overwrite if the string is the same!
-    if (inValue.compare(value, Qt::CaseInsensitive) == 0) {
+    QStringView value = QStringView(line).mid(valueBegin, valueSize);
+    if (value.compare(inValue, Qt::CaseInsensitive) == 0) {
         return;
     }
 
-    line = variable + QString("=") + inValue;
+    QStringView variable = QStringView(line).left(variableSize);
+    QStringView comment = QStringView(line).mid(commentBegin).trimmed();
+    QString updated;
+    updated.reserve(variable.size() + 1 + inValue.size() + (comment.size() > 0 ? 5 + comment.size() : 0));
+    updated.append(variable.data(), variable.size());
+    updated += QLatin1Char('=');
+    updated += inValue;
+    valueBegin = variableSize + 1;
+    valueSize = (int) inValue.size();
 
     if (comment.size() > 0) {
-        line = line + QString("     ") + comment;
+        updated += QLatin1String("     ");
+        commentBegin = (int) updated.size();
+        updated.append(comment.data(), comment.size());
+    } else {
+        commentBegin = (int) updated.size();
     }
 
-    value = inValue;
+    line = updated;
+    updateQtLine();
 }
 
 int ZDLLine::findComment(char delim) {
@@ -102,30 +167,38 @@ void ZDLLine::parse() {
     }
 
     if (cloc != -1) {
-        //Strip out comment
-        comment = line.mid(cloc, line.size()).trimmed();
-
+        //The comment runs to the end of the line
+        commentBegin = cloc;
     }
 
-    int loc = (int) line.indexOf("=", 0);
+    //The line is trimmed, so the variable starts it and the value ends it
+    QStringView view(line);
+    qsizetype loc = view.indexOf(u'=');
     if (loc > -1) {
-        variable = line.mid(0, loc).trimmed();
-        value = line.mid(loc + 1, line.length() - loc - 1).trimmed();
+        QStringView value = view.mid(loc + 1).trimmed();
+        variableSize = (int) view.left(loc).trimmed().size();
+        valueBegin = value.isEmpty() ? (int) loc + 1 : (int) (value.data() - view.data());
+        valueSize = (int) value.size();
         type = 0;
     } else {
         type = 1;
-        variable = line;
-        value = "";
+        variableSize = (int) line.size();
+        valueBegin = variableSize;
+        valueSize = 0;
     }
 
 }
 
-ZDLLine *ZDLLine::clone() {
+ZDLLine *ZDLLine::clone() const {
     auto *copy = new ZDLLine();
-    copy->variable = variable;
-    copy->comment = comment;
     copy->line = line;
-    copy->value = value;
+#ifdef _WIN32
+    copy->qtSepLine = qtSepLine;
+#endif
+    copy->variableSize = variableSize;
+    copy->valueBegin = valueBegin;
+    copy->valueSize = valueSize;
+    copy->commentBegin = commentBegin;
     copy->type = type;
     copy->flags = flags;
     return copy;
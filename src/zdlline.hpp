@@ -29,23 +29,39 @@ class ZDLLine {
     friend class ZDLVariables;
 
 public:
-    explicit ZDLLine(const QString &inLine);
+    // Keeps a copy of inLine, so every line read costs one allocation for
+    // its text. Referencing the file buffer instead would tie each line to
+    // the configuration that read it, and clones outlive that.
+    explicit ZDLLine(QStringView inLine);
 
     ZDLLine();
 
     ~ZDLLine();
 
+    // Lines come out of ZDLNodePool::lines()
+    static void *operator new(std::size_t size);
+
+    static void operator delete(void *block, std::size_t size);
+
     static int getType();
 
-    QString getValue();
+    QString getValue() const;
+
+    QString getVariable() const;
+
+    QString getLine() const;
 
-    QString getVariable();
+    // Same as above, but pointing into the line itself. They stay valid until
+    // the value is changed or the line deleted.
+    QStringView getValueView() const;
 
-    QString getLine();
+    QStringView getVariableView() const;
+
+    QStringView getLineView() const;
 
     void setValue(const QString &inValue);
 
-    ZDLLine *clone();
+    ZDLLine *clone() const;
 
     void setIsCopy(bool val);
 
@@ -62,10 +78,22 @@ private:
 
     int findComment(char delim);
 
-    int type;
+    // The line with Qt separators, the views are cut out of this
+    QStringView qtLine() const;
+
+    void updateQtLine();
+
+    // The trimmed line as it goes into the file. Everything else is a range
+    // of it: the variable starts the line, and the comment ends it.
     QString line;
-    QString comment;
-    QString value;
-    QString variable;
+#ifdef _WIN32
+    // Null unless the line has native separators to convert
+    QString qtSepLine;
+#endif
+    int variableSize{};
+    int valueBegin{};
+    int valueSize{};
+    int commentBegin{};
+    qint8 type;
     int flags{};
 };
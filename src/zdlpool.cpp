@@ -0,0 +1,84 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <new>
+#include "zdlcommon.h"
+
+namespace {
+    std::size_t roundBlockSize(std::size_t size) {
+        const std::size_t align = alignof(std::max_align_t);
+        size = qMax(size, sizeof(void *));
+        return (size + align - 1) / align * align;
+    }
+}
+
+ZDLNodePool::ZDLNodePool(std::size_t size, int perChunk)
+        : size(roundBlockSize(size)), perChunk(perChunk), inUse(0), freeList(nullptr) {
+}
+
+void *ZDLNodePool::allocate() {
+    QMutexLocker locker(&mutex);
+    if (!freeList) {
+        //Blocks of a new chunk are chained in address order
+        char *chunk = static_cast<char *>(::operator new(size * perChunk));
+        chunkList.push_back(chunk);
+        for (int i = perChunk - 1; i >= 0; i--) {
+            auto *block = reinterpret_cast<Block *>(chunk + size * i);
+            block->next = freeList;
+            freeList = block;
+        }
+    }
+
+    Block *block = freeList;
+    freeList = block->next;
+    inUse++;
+    return block;
+}
+
+void ZDLNodePool::release(void *block) {
+    if (!block) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    auto *freed = static_cast<Block *>(block);
+    freed->next = freeList;
+    freeList = freed;
+    inUse--;
+}
+
+int ZDLNodePool::chunks() const {
+    QMutexLocker locker(&mutex);
+    return (int) chunkList.size();
+}
+
+int ZDLNodePool::live() const {
+    QMutexLocker locker(&mutex);
+    return inUse;
+}
+
+//Never destroyed, configurations held by other statics may outlive them
+ZDLNodePool &ZDLNodePool::sections() {
+    static auto *pool = new ZDLNodePool(sizeof(ZDLSection), 32);
+    return *pool;
+}
+
+ZDLNodePool &ZDLNodePool::lines() {
+    static auto *pool = new ZDLNodePool(sizeof(ZDLLine), 256);
+    return *pool;
+}
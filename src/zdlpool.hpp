@@ -0,0 +1,67 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <QMutex>
+#include <cstddef>
+#include <vector>
+
+// Fixed size blocks for the nodes of the configuration engine, cut out of
+// large chunks. Deleted nodes go on a free list for the next one to reuse,
+// so the sections and lines themselves take a handful of allocations rather
+// than one each. What they hold, their strings and the indexes of a
+// section, still allocates on its own. Nodes move between configurations
+// (sections are cloned from one into another), so the pools are shared by
+// all of them instead of belonging to one.
+class ZDLNodePool {
+public:
+    ZDLNodePool(std::size_t size, int perChunk);
+
+    ZDLNodePool(const ZDLNodePool &) = delete;
+
+    ZDLNodePool &operator=(const ZDLNodePool &) = delete;
+
+    void *allocate();
+
+    void release(void *block);
+
+    // Chunks taken from the system so far, and blocks handed out right now
+    int chunks() const;
+
+    int live() const;
+
+    std::size_t blockSize() const {
+        return size;
+    }
+
+    static ZDLNodePool &sections();
+
+    static ZDLNodePool &lines();
+
+private:
+    struct Block {
+        Block *next;
+    };
+
+    std::size_t size;
+    int perChunk;
+    int inUse;
+    Block *freeList;
+    std::vector<void *> chunkList;
+    mutable QMutex mutex;
+};
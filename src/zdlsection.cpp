@@ -18,6 +18,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <climits>
 #include <QRegularExpression>
 #include <utility>
 #include "zdlcommon.h"
@@ -27,11 +28,58 @@
 #define READUNLOCK() (releaseReadLock(__FILE__,__LINE__))
 #define WRITEUNLOCK() (releaseWriteLock(__FILE__,__LINE__))
 
+#if defined(_WIN32)
+#define ENDOFLINE QLatin1String("\r\n")
+#else
+#define ENDOFLINE QLatin1String("\n")
+#endif
+
+namespace {
+    std::atomic<quint64> generation_clock{0};
+
+    //Splits variables such as file3 or i3n into prefix, index and suffix.
+    //The prefix and suffix hold no digits, and only the prefix must be there.
+    bool isDigit(QChar c) {
+        return c >= u'0' && c <= u'9';
+    }
+
+    bool splitNumbered(QStringView variable, QStringView &prefix, int &index, QStringView &suffix) {
+        qsizetype begin = 0;
+        while (begin < variable.size() && !isDigit(variable[begin])) {
+            begin++;
+        }
+
+        qsizetype end = begin;
+        index = 0;
+        while (end < variable.size() && isDigit(variable[end])) {
+            if (index > (INT_MAX - 9) / 10) {
+                return false;
+            }
+            index = index * 10 + (variable[end].unicode() - u'0');
+            end++;
+        }
+
+        if (begin == 0 || end == begin) {
+            return false;
+        }
+
+        for (qsizetype i = end; i < variable.size(); i++) {
+            if (isDigit(variable[i])) {
+                return false;
+            }
+        }
+
+        prefix = variable.left(begin);
+        suffix = variable.mid(end);
+        return true;
+    }
+}
+
 ZDLSection::ZDLSection(QString name) {
     reads = 0;
     writes = 0;
+    generation = nextGeneration();
     sectionName = std::move(name);
-    mutex = LOCK_BUILDER();
     isCopy = false;
 }
 
@@ -42,57 +90,61 @@ ZDLSection::~ZDLSection() {
         lines.pop_front();
         delete line;
     }
+    lineIndex.clear();
+    numberedIndex.clear();
     WRITEUNLOCK();
-    delete mutex;
+}
+
+void *ZDLSection::operator new(std::size_t size) {
+    if (size > ZDLNodePool::sections().blockSize()) {
+        return ::operator new(size);
+    }
+    return ZDLNodePool::sections().allocate();
+}
+
+void ZDLSection::operator delete(void *block, std::size_t size) {
+    if (size > ZDLNodePool::sections().blockSize()) {
+        ::operator delete(block);
+        return;
+    }
+    ZDLNodePool::sections().release(block);
 }
 
 void ZDLSection::setSpecial(int inFlags) {
     flags = inFlags;
 }
 
-int ZDLSection::hasVariable(const QString &variable) {
+int ZDLSection::hasVariable(const QString &variable) const {
     reads++;
     READLOCK();
-    for (auto line: lines) {
-        if (line->getVariable().compare(variable) == 0) {
-            READUNLOCK();
-            return true;
-        }
-    }
+    bool found = lineIndex.contains(variable);
     READUNLOCK();
-    return false;
+    return found;
 }
 
 void ZDLSection::deleteVariable(const QString &variable) {
     WRITELOCK();
     reads++;
-    for (int i = 0; i < lines.size(); i++) {
-        ZDLLine *line = lines[i];
-        if (line->getVariable().compare(variable) == 0) {
-            lines.remove(i);
-            delete line;
-            WRITEUNLOCK();
-            return;
-        }
+    if (ZDLLine *line = lineIndex.value(variable, nullptr)) {
+        removeLine(line);
+        delete line;
     }
     WRITEUNLOCK();
 }
 
-QString ZDLSection::findVariable(const QString &variable) {
+QString ZDLSection::findVariable(const QString &variable) const {
     reads++;
     READLOCK();
-    for (auto line: lines) {
-        if (line->getVariable().compare(variable) == 0) {
-            QString val(line->getValue());
-            READUNLOCK();
-            return val;
-        }
+    if (ZDLLine *line = lineIndex.value(variable, nullptr)) {
+        QString val(line->getValue());
+        READUNLOCK();
+        return val;
     }
     READUNLOCK();
     return {""};
 }
 
-int ZDLSection::getRegex(const QString &regex, QVector<ZDLLine *> &vctr) {
+int ZDLSection::getRegex(const QString &regex, QVector<const ZDLLine *> &vctr) const {
 #ifdef QT_CORE_LIB
     QRegularExpression rx(regex);
     QRegularExpressionMatch match;
@@ -101,9 +153,7 @@ int ZDLSection::getRegex(const QString &regex, QVector<ZDLLine *> &vctr) {
     for (auto line: lines) {
         match = rx.match(line->getVariable());
         if (match.hasMatch()) {
-            ZDLLine *copy = line->clone();
-            copy->setIsCopy(true);
-            vctr.push_back(copy);
+            vctr.push_back(line);
         }
     }
     READUNLOCK();
@@ -113,82 +163,153 @@ int ZDLSection::getRegex(const QString &regex, QVector<ZDLLine *> &vctr) {
 #endif
 }
 
+ZDLSection::IndexedList ZDLSection::list(const QString &prefix, const QStringList &suffixes) const {
+    reads++;
+    QMap<int, QVector<const ZDLLine *>> merged;
+    READLOCK();
+    for (const QString &suffix: suffixes) {
+        auto it = numberedIndex.find({prefix, suffix});
+        if (it == numberedIndex.end()) {
+            continue;
+        }
+        for (auto entry = it->begin(); entry != it->end(); ++entry) {
+            merged[entry.key()].push_back(entry.value());
+        }
+    }
+    READUNLOCK();
+
+    IndexedList entries;
+    for (auto it = merged.begin(); it != merged.end(); ++it) {
+        for (const ZDLLine *line: it.value()) {
+            entries.push_back({it.key(), line});
+        }
+    }
+    return entries;
+}
+
+QVector<ZDLSection::IndexedPair> ZDLSection::pairs(const QString &prefix, const QString &first,
+                                                   const QString &second) const {
+    reads++;
+    QVector<IndexedPair> entries;
+    READLOCK();
+    auto firsts = numberedIndex.find({prefix, first});
+    auto seconds = numberedIndex.find({prefix, second});
+    if (firsts != numberedIndex.end() && seconds != numberedIndex.end()) {
+        //Both are sorted by index, so walk them side by side
+        auto a = firsts->begin();
+        auto b = seconds->begin();
+        while (a != firsts->end() && b != seconds->end()) {
+            if (a.key() < b.key()) {
+                ++a;
+            } else if (b.key() < a.key()) {
+                ++b;
+            } else {
+                entries.push_back({a.key(), a.value(), b.value()});
+                ++a;
+                ++b;
+            }
+        }
+    }
+    READUNLOCK();
+    return entries;
+}
+
+const ZDLLine *ZDLSection::at(const QString &prefix, int index, const QString &suffix) const {
+    reads++;
+    const ZDLLine *line = nullptr;
+    READLOCK();
+    auto it = numberedIndex.find({prefix, suffix});
+    if (it != numberedIndex.end()) {
+        line = it->value(index, nullptr);
+    }
+    READUNLOCK();
+    return line;
+}
+
 int ZDLSection::setValue(const QString &variable, const QString &value) {
     writes++;
     WRITELOCK();
 
-    for (auto line: lines) {
-        if (line->getVariable().compare(variable) == 0) {
-            if ((line->getFlags() & FLAG_NOWRITE) == FLAG_NOWRITE) {
-                LOGDATAO() << "Cannot change value of FLAG_NOWRITE" << Qt::endl;
-                return -1;
-            }
-            line->setValue(value);
+    if (ZDLLine *line = lineIndex.value(variable, nullptr)) {
+        if ((line->getFlags() & FLAG_NOWRITE) == FLAG_NOWRITE) {
+            LOGDATAO() << "Cannot change value of FLAG_NOWRITE" << Qt::endl;
             WRITEUNLOCK();
-            return 0;
+            return -1;
         }
+        line->setValue(value);
+        generation = nextGeneration();
+        WRITEUNLOCK();
+        return 0;
     }
     //We can't find the line, create a new one.
     QString buffer = variable;
     buffer.append("=");
     buffer.append(value);
     auto *line = new ZDLLine(buffer);
-    lines.push_back(line);
+    insertLine(line);
     WRITEUNLOCK();
     return 0;
 }
 
-int ZDLSection::streamWrite(QIODevice *stream) {
-
-#if defined(_WIN32)
-    QString el("\r\n");
-#define ENDOFLINE el
-#else
-    QString el("\n");
-#define ENDOFLINE el
-#endif
+int ZDLSection::streamWrite(QString &buffer) {
     READLOCK();
-    QTextStream tstream(stream);
     //Write only if we have stuff to write
     if (!lines.empty()) {
         writes++;
         //Global's don't have a section name
         if (sectionName.length() > 0) {
-            tstream << "[" << sectionName << "]" << ENDOFLINE;
+            buffer += u'[';
+            buffer += sectionName;
+            buffer += u']';
+            buffer += ENDOFLINE;
         }
         for (auto line: lines) {
             if ((line->getFlags() & FLAG_VIRTUAL) == 0 && (line->getFlags() & FLAG_TEMP) == 0) {
-                tstream << line->getLine() << ENDOFLINE;
+                buffer += line->getLine();
+                buffer += ENDOFLINE;
             } else {
                 LOGDATAO() << "Ignoring FLAG_VIRTUAL and FLAG_TEMP entries" << Qt::endl;
             }
         }
-        tstream << ENDOFLINE;
+        buffer += ENDOFLINE;
     }
     READUNLOCK();
     return 0;
 }
 
-QString ZDLSection::getName() {
-    reads++;
-    return sectionName;
-}
-
-ZDLLine *ZDLSection::findLine(const QString &inVar) {
+qsizetype ZDLSection::streamSize() const {
+    const qsizetype eol = ENDOFLINE.size();
+    qsizetype size = 0;
     READLOCK();
-    for (auto line: lines) {
-        if (line->getVariable().compare(inVar) == 0) {
-            qDebug() << "UNSAFE OPERATION AT " << __FILE__ << ":" << __LINE__ << Qt::endl;
-            READUNLOCK();
-            return line;
+    if (!lines.empty()) {
+        if (sectionName.length() > 0) {
+            size += sectionName.size() + 2 + eol;
+        }
+        for (auto line: lines) {
+            if ((line->getFlags() & FLAG_VIRTUAL) == 0 && (line->getFlags() & FLAG_TEMP) == 0) {
+                size += line->getLine().size() + eol;
+            }
         }
+        size += eol;
     }
     READUNLOCK();
+    return size;
+}
 
-    return nullptr;
+quint64 ZDLSection::nextGeneration() {
+    return ++generation_clock;
 }
 
-int ZDLSection::addLine(const QString &linedata) {
+QString ZDLSection::getName() const {
+    reads++;
+    return sectionName;
+}
+
+ZDLLine *ZDLSection::findLine(const QString &inVar) {
+    return lineIndex.value(inVar, nullptr);
+}
+
+int ZDLSection::addLine(QStringView linedata) {
     if (linedata.isEmpty()) return 0;
 
     writes++;
@@ -197,18 +318,19 @@ int ZDLSection::addLine(const QString &linedata) {
     ZDLLine *ptr = findLine(newl->getVariable());
 
     if (ptr == nullptr) {
-        lines.push_back(newl);
+        insertLine(newl);
         WRITEUNLOCK();
         return 0;
     } else {
         ptr->setValue(newl->getValue());
+        generation = nextGeneration();
         delete newl;
         WRITEUNLOCK();
         return 1;
     }
 }
 
-ZDLSection *ZDLSection::clone() {
+ZDLSection *ZDLSection::clone() const {
     READLOCK();
     auto *copy = new ZDLSection(sectionName);
     for (auto &line: lines) {
@@ -224,25 +346,26 @@ ZDLSection *ZDLSection::clone() {
 }
 
 int ZDLSection::getFlagsForValue(const QString &var) {
+    int rc = -1;
     READLOCK();
-    for (auto line: lines) {
-        if (line->getVariable().compare(var) == 0) {
-            return line->getFlags();
-        }
+    if (ZDLLine *line = lineIndex.value(var, nullptr)) {
+        rc = line->getFlags();
     }
     READUNLOCK();
-    return -1;
+    return rc;
 }
 
 bool ZDLSection::setFlagsForValue(const QString &var, int value) {
-    READLOCK();
-    for (auto line: lines) {
-        if (line->getVariable().compare(var) == 0) {
-            return line->setFlags(value);
+    bool rc = false;
+    WRITELOCK();
+    if (ZDLLine *line = lineIndex.value(var, nullptr)) {
+        rc = line->setFlags(value);
+        if (rc) {
+            generation = nextGeneration();
         }
     }
-    READUNLOCK();
-    return false;
+    WRITEUNLOCK();
+    return rc;
 }
 
 bool ZDLSection::deleteRegex(const QString &regex) {
@@ -262,6 +385,93 @@ bool ZDLSection::deleteRegex(const QString &regex) {
         }
     }
 
+    if (rc) {
+        reindexLines();
+    }
+
     WRITEUNLOCK();
     return rc;
 }
+
+void ZDLSection::addLine(ZDLLine *line) {
+    WRITELOCK();
+    insertLine(line);
+    WRITEUNLOCK();
+}
+
+void ZDLSection::insertLine(ZDLLine *line) {
+    lines.push_back(line);
+    indexLine(line);
+    generation = nextGeneration();
+}
+
+void ZDLSection::indexLine(ZDLLine *line) {
+    //Like a scan in order would, lookups find the first of duplicates
+    QString variable = line->getVariable();
+    if (!lineIndex.contains(variable)) {
+        lineIndex.insert(variable, line);
+    }
+
+    QStringView prefix;
+    QStringView suffix;
+    int index = 0;
+    if (splitNumbered(variable, prefix, index, suffix)) {
+        QMap<int, ZDLLine *> &numbered = numberedIndex[{prefix.toString(), suffix.toString()}];
+        if (!numbered.contains(index)) {
+            numbered.insert(index, line);
+        }
+    }
+}
+
+void ZDLSection::reindexLines() {
+    generation = nextGeneration();
+    lineIndex.clear();
+    numberedIndex.clear();
+    for (auto line: lines) {
+        indexLine(line);
+    }
+}
+
+void ZDLSection::removeLine(ZDLLine *line) {
+    lines.removeOne(line);
+    generation = nextGeneration();
+
+    QString variable = line->getVariable();
+    if (lineIndex.value(variable) == line) {
+        lineIndex.remove(variable);
+        for (auto other: lines) {
+            if (other->getVariableView() == variable) {
+                lineIndex.insert(variable, other);
+                break;
+            }
+        }
+    }
+
+    QStringView prefix;
+    QStringView suffix;
+    int index = 0;
+    if (!splitNumbered(variable, prefix, index, suffix)) {
+        return;
+    }
+
+    //file1 and file01 share an index, the first one of them keeps it
+    auto it = numberedIndex.find({prefix.toString(), suffix.toString()});
+    if (it == numberedIndex.end() || it->value(index) != line) {
+        return;
+    }
+
+    it->remove(index);
+    for (auto other: lines) {
+        QStringView otherPrefix;
+        QStringView otherSuffix;
+        int otherIndex = 0;
+        if (splitNumbered(other->getVariableView(), otherPrefix, otherIndex, otherSuffix)
+            && otherIndex == index && otherPrefix == prefix && otherSuffix == suffix) {
+            it->insert(index, other);
+            break;
+        }
+    }
+    if (it->isEmpty()) {
+        numberedIndex.erase(it);
+    }
+}
@@ -29,31 +29,77 @@ public:
 
     ~ZDLSection();
 
-    int addLine(const QString &data);
+    // Sections come out of ZDLNodePool::sections()
+    static void *operator new(std::size_t size);
 
-    QString getName();
+    static void operator delete(void *block, std::size_t size);
+
+    int addLine(QStringView data);
+
+    QString getName() const;
 
     void setSpecial(int inFlags);
 
-    QString findVariable(const QString &variable);
+    QString findVariable(const QString &variable) const;
 
-    int hasVariable(const QString &variable);
+    int hasVariable(const QString &variable) const;
 
     void deleteVariable(const QString &variable);
 
     int setValue(const QString &variable, const QString &value);
 
-    int streamWrite(QIODevice *stream);
+    // Appends the section as it goes into a file, streamSize() characters
+    int streamWrite(QString &buffer);
+
+    qsizetype streamSize() const;
+
+    // Changes whenever the section does. Generations come from one clock
+    // shared by all sections and configurations, so a later change always
+    // has a higher generation.
+    quint64 getGeneration() const {
+        return generation;
+    }
+
+    static quint64 nextGeneration();
+
+    // Appends the lines whose variable matches regex. They belong to the
+    // section and are only valid as long as the lines aren't deleted.
+    int getRegex(const QString &regex, QVector<const ZDLLine *> &vctr) const;
+
+    // A numbered variable such as file3 or i3n, split into its prefix, index
+    // and suffix. Lines are borrowed, like the ones getRegex gives out.
+    struct IndexedLine {
+        int index;
+        const ZDLLine *line;
+    };
+
+    struct IndexedPair {
+        int index;
+        const ZDLLine *first;
+        const ZDLLine *second;
+    };
+
+    using IndexedList = QVector<IndexedLine>;
 
-    int getRegex(const QString &regex, QVector<ZDLLine *> &vctr);
+    // The lines named prefix<N>suffix in order of N, for each of suffixes.
+    // list("file", {"", "d"}) gives file0, file1d, file2... Where several
+    // suffixes share an index, they come in the order they're given.
+    IndexedList list(const QString &prefix, const QStringList &suffixes = {QString()}) const;
 
+    // The indexes that have both prefix<N>first and prefix<N>second, in
+    // order. pairs("i", "n", "f") gives the name and file of each IWAD.
+    QVector<IndexedPair> pairs(const QString &prefix, const QString &first, const QString &second) const;
+
+    // The line named prefix<index>suffix, nullptr if there isn't one
+    const ZDLLine *at(const QString &prefix, int index, const QString &suffix = QString()) const;
+
+    // In file order. Read only, lines are added and removed through the
+    // methods above so that the index stays in sync.
     QVector<ZDLLine *> lines;
 
-    ZDLSection *clone();
+    ZDLSection *clone() const;
 
-    void addLine(ZDLLine *line) {
-        lines.push_back(line);
-    }
+    void addLine(ZDLLine *line);
 
     void setIsCopy(bool copy) {
         isCopy = copy;
@@ -69,7 +115,7 @@ public:
     bool deleteRegex(const QString &regex);
 
 protected:
-    void readLock(const char *file, int line) {
+    void readLock(const char *file, int line) const {
         LOGDATAO() << "ReadLockGet@" << file << ":" << line << Qt::endl;
         GET_READLOCK(mutex);
     }
@@ -82,7 +128,7 @@ protected:
         GET_WRITELOCK(mutex);
     }
 
-    void releaseReadLock(const char *file, int line) {
+    void releaseReadLock(const char *file, int line) const {
         LOGDATAO() << "ReadLockRelease@" << file << ":" << line << Qt::endl;
         RELEASE_READLOCK(mutex);
     }
@@ -92,7 +138,7 @@ protected:
         RELEASE_WRITELOCK(mutex);
     }
 
-    bool tryReadLock(const char *file, int line, int timeout = 999999999) {
+    bool tryReadLock(const char *file, int line, int timeout = 999999999) const {
         LOGDATAO() << "ReadLockTryGet@" << file << ":" << line << Qt::endl;
         return TRY_READLOCK(mutex, timeout);
     }
@@ -106,13 +152,30 @@ protected:
     }
 
 private:
-    LOCK_CLASS *mutex;
-    int reads;
-    int writes;
+    mutable LOCK_CLASS mutex;
+    mutable std::atomic<int> reads;
+    std::atomic<int> writes;
+    std::atomic<quint64> generation;
     bool isCopy;
 
+    // These expect the write lock to be held
     ZDLLine *findLine(const QString &inVar);
 
+    void insertLine(ZDLLine *line);
+
+    void removeLine(ZDLLine *line);
+
+    void indexLine(ZDLLine *line);
+
+    void reindexLines();
+
+    // Variable names to lines
+    QHash<QString, ZDLLine *> lineIndex;
+
+    // Numbered variables by (prefix, suffix), then by index
+    using NumberedKey = QPair<QString, QString>;
+    QHash<NumberedKey, QMap<int, ZDLLine *>> numberedIndex;
+
     int flags{};
     QString sectionName;
 };
@@ -0,0 +1,116 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Readers of a configuration share its lock: getValue goes through on any
+// number of threads while another read is in progress, and keeps seeing
+// whole values while a writer changes them.
+
+#include <QThreadPool>
+#include <atomic>
+#include "zdlcommon.h"
+
+QDebug *zdlDebug = nullptr;
+
+namespace {
+    const int readers = 8;
+    const int reads = 2000;
+    const int writes = 20000;
+
+    //Gives the test the lock helpers the configuration keeps to itself
+    class LockableConf : public ZDLConf {
+    public:
+        using ZDLConf::readLock;
+        using ZDLConf::releaseReadLock;
+    };
+
+    //Readers must get through while the test holds a read lock itself
+    bool readsAreShared(LockableConf &zconf) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(readers);
+        std::atomic<int> done = 0;
+
+        zconf.readLock();
+        for (int i = 0; i < readers; i++) {
+            pool.start([&zconf, &done]() {
+                for (int j = 0; j < reads; j++) {
+                    zconf.getValue("zdl.save", "file" + QString::number(j % 100));
+                }
+                done++;
+            });
+        }
+
+        bool finished = pool.waitForDone(10000);
+        zconf.releaseReadLock();
+        pool.waitForDone();
+
+        if (!finished) {
+            qCritical() << "Readers blocked on a held read lock," << done << "of" << readers << "finished";
+        }
+        return finished;
+    }
+
+    //Readers racing a writer only ever see one of the values it writes
+    bool readsSeeWholeValues(LockableConf &zconf) {
+        const QString values[] = {"MAP01", "E1M1 with a longer value"};
+        QThreadPool pool;
+        pool.setMaxThreadCount(readers + 1);
+        std::atomic<bool> writing = true;
+        std::atomic<int> torn = 0;
+        std::atomic<int> read_count = 0;
+
+        zconf.setValue("zdl.save", "warp", values[0]);
+
+        for (int i = 0; i < readers; i++) {
+            pool.start([&]() {
+                while (writing) {
+                    QString value = zconf.getValue("zdl.save", "warp");
+                    if (value != values[0] && value != values[1]) {
+                        torn++;
+                    }
+                    read_count++;
+                }
+            });
+        }
+
+        pool.start([&]() {
+            for (int i = 0; i < writes; i++) {
+                zconf.setValue("zdl.save", "warp", values[i % 2]);
+            }
+            writing = false;
+        });
+
+        pool.waitForDone();
+
+        qInfo() << read_count << "reads raced" << writes << "writes";
+        if (torn) {
+            qCritical() << torn << "reads saw a value that was never written";
+        }
+        return !torn;
+    }
+}
+
+int main() {
+    LockableConf zconf;
+    for (int i = 0; i < 100; i++) {
+        zconf.setValue("zdl.save", "file" + QString::number(i), "/doom/wads/file" + QString::number(i) + ".wad");
+    }
+
+    bool ok = readsAreShared(zconf);
+    ok = readsSeeWholeValues(zconf) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Sections and lines of a configuration come out of the node pools: reading
+// and cloning one takes a chunk per 32 sections or 256 lines, deleting it
+// hands every node back and reading it again reuses them.
+
+#include <QTemporaryFile>
+#include <QTextStream>
+#include "zdlcommon.h"
+
+QDebug *zdlDebug = nullptr;
+
+namespace {
+    const int sections = 40;
+    const int lines_per_section = 50;
+
+    bool failed = false;
+
+    void check(bool ok, const char *what) {
+        if (!ok) {
+            qCritical() << "Failed:" << what;
+            failed = true;
+        }
+    }
+
+    int chunksFor(int nodes, int perChunk) {
+        return (nodes + perChunk - 1) / perChunk;
+    }
+
+    struct Counts {
+        int sectionChunks;
+        int sectionsLive;
+        int lineChunks;
+        int linesLive;
+
+        static Counts now() {
+            return {ZDLNodePool::sections().chunks(), ZDLNodePool::sections().live(),
+                    ZDLNodePool::lines().chunks(), ZDLNodePool::lines().live()};
+        }
+    };
+}
+
+int main() {
+    QTemporaryFile file;
+    if (!file.open()) {
+        qCritical() << "Cannot create" << file.fileName();
+        return 1;
+    }
+    {
+        QTextStream out(&file);
+        for (int i = 0; i < sections; i++) {
+            out << "[section" << i << "]\n";
+            for (int j = 0; j < lines_per_section; j++) {
+                out << "file" << j << "=/home/player/wads/pwad" << j << ".wad\n";
+            }
+        }
+    }
+    file.close();
+
+    //Plus the nameless section readINI keeps lines before the first header in
+    const int section_nodes = sections + 1;
+    const int line_nodes = sections * lines_per_section;
+
+    Counts start = Counts::now();
+    check(start.sectionsLive == 0 && start.linesLive == 0, "no nodes live before reading");
+
+    auto *zconf = new ZDLConf();
+    check(zconf->readINI(file.fileName()) == 0, "reading the configuration");
+
+    Counts read = Counts::now();
+    check(read.sectionsLive == section_nodes, "one section node per section");
+    check(read.linesLive == line_nodes, "one line node per line");
+    check(read.sectionChunks - start.sectionChunks <= chunksFor(section_nodes, 32), "section chunks after reading");
+    check(read.lineChunks - start.lineChunks <= chunksFor(line_nodes, 256), "line chunks after reading");
+
+    ZDLConf *copy = zconf->clone();
+
+    Counts cloned = Counts::now();
+    check(cloned.sectionsLive == 2 * section_nodes, "cloning copies every section");
+    check(cloned.linesLive == 2 * line_nodes, "cloning copies every line");
+    check(cloned.sectionChunks <= start.sectionChunks + chunksFor(2 * section_nodes, 32), "section chunks after cloning");
+    check(cloned.lineChunks <= start.lineChunks + chunksFor(2 * line_nodes, 256), "line chunks after cloning");
+
+    delete copy;
+    delete zconf;
+
+    Counts deleted = Counts::now();
+    check(deleted.sectionsLive == 0 && deleted.linesLive == 0, "deleting hands every node back");
+
+    zconf = new ZDLConf();
+    zconf->readINI(file.fileName());
+
+    Counts reread = Counts::now();
+    check(reread.sectionChunks == cloned.sectionChunks && reread.lineChunks == cloned.lineChunks,
+          "reading again reuses the freed nodes");
+    delete zconf;
+
+    qInfo() << "Section chunks:" << cloned.sectionChunks << "line chunks:" << cloned.lineChunks;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Times readINI on a generated configuration with a large number of files,
+// source ports and IWADs. Usage: conf_read_bench [entries] [iterations]
+
+#include <QElapsedTimer>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include "zdlcommon.h"
+
+QDebug *zdlDebug = nullptr;
+
+namespace {
+    //Returns the number of non-empty lines written
+    int writeConfig(QIODevice &file, int entries) {
+        QTextStream out(&file);
+        out << "; Generated for conf_read_bench\n\n";
+
+        out << "[zdl.ports]\n";
+        for (int i = 0; i < entries; i++) {
+            out << "p" << i << "n=Source port " << i << "\n";
+            out << "p" << i << "f=/usr/games/ports/port" << i << "/gzdoom\n";
+        }
+
+        out << "\n[zdl.iwads]\n";
+        for (int i = 0; i < entries; i++) {
+            out << "i" << i << "n=IWAD " << i << "\n";
+            out << "i" << i << "f=/usr/share/games/doom/iwad" << i << ".wad\n";
+        }
+
+        out << "\n[zdl.save]\n";
+        for (int i = 0; i < entries; i++) {
+            out << "file" << i << (i % 7 ? "" : "d") << "=/home/player/wads/pwad" << i << ".pk3\n";
+        }
+        out << "warp=MAP01\nskill=4\n";
+
+        out.flush();
+        return out.status() == QTextStream::Ok ? entries * 5 + 6 : 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    int entries = argc > 1 ? QString(argv[1]).toInt() : 5000;
+    int iterations = argc > 2 ? QString(argv[2]).toInt() : 20;
+    if (entries <= 0 || iterations <= 0) {
+        qCritical() << "Usage: conf_read_bench [entries] [iterations]";
+        return 1;
+    }
+
+    QTemporaryFile file;
+    if (!file.open()) {
+        qCritical() << "Cannot create" << file.fileName();
+        return 1;
+    }
+    int lines = writeConfig(file, entries);
+    file.close();
+    if (!lines) {
+        qCritical() << "Cannot write" << file.fileName();
+        return 1;
+    }
+
+    //One read first, so that the file is in the page cache for all timed ones
+    ZDLConf warmup;
+    warmup.readINI(file.fileName());
+
+    qint64 best = -1;
+    qint64 total = 0;
+    for (int i = 0; i < iterations; i++) {
+        ZDLConf zconf;
+        QElapsedTimer timer;
+        timer.start();
+        if (zconf.readINI(file.fileName())) {
+            qCritical() << "Cannot read" << file.fileName();
+            return 1;
+        }
+        qint64 elapsed = timer.nsecsElapsed();
+
+        total += elapsed;
+        best = best < 0 ? elapsed : qMin(best, elapsed);
+    }
+
+    qInfo().noquote() << QString("%1 lines, %2 reads: best %3 ms, mean %4 ms, %5 ns per line")
+            .arg(lines)
+            .arg(iterations)
+            .arg(best / 1e6, 0, 'f', 3)
+            .arg(total / iterations / 1e6, 0, 'f', 3)
+            .arg(best / lines);
+    return 0;
+}
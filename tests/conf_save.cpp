@@ -0,0 +1,185 @@
+/*
+ * This file is part of qZDL
+ * Copyright (C) 2023  spacebub
+ * 
+ * qZDL is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// writeINI leaves a file alone when the configuration still matches it:
+// only after a read into an empty configuration or a write of that file,
+// with no change through the configuration or any of its sections since,
+// and only while the file is still there. Anything it does write reads
+// back the same.
+
+#include <QTemporaryDir>
+#include <functional>
+#include "zdlcommon.h"
+
+QDebug *zdlDebug = nullptr;
+
+namespace {
+    const QDateTime long_ago(QDate(2000, 1, 1), QTime(0, 0));
+
+    bool failed = false;
+
+    void check(bool ok, const char *what) {
+        if (!ok) {
+            qCritical() << "Failed:" << what;
+            failed = true;
+        }
+    }
+
+    QByteArray contents(const QString &path) {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+
+    bool writeFile(const QString &path, const QByteArray &data) {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size();
+    }
+
+    //Backdates the file, so that any write shows up in its mtime whatever
+    //the resolution of the file system's clock
+    void backdate(const QString &path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadWrite | QIODevice::Append)
+            || !file.setFileTime(long_ago, QFileDevice::FileModificationTime)) {
+            qCritical() << "Cannot backdate" << path;
+            failed = true;
+        }
+    }
+
+    bool rewritten(const QString &path) {
+        return QFileInfo(path).lastModified() != long_ago;
+    }
+
+    //Reads path into a fresh configuration and writes it back after change
+    bool rewrites(const QString &path, const std::function<void(ZDLConf &)> &change) {
+        ZDLConf zconf;
+        zconf.readINI(path);
+        change(zconf);
+        backdate(path);
+        check(zconf.writeINI(path) == 0, "writing the configuration");
+        return rewritten(path);
+    }
+}
+
+int main() {
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qCritical() << "Cannot create a temporary directory";
+        return 1;
+    }
+
+    //Already carries the conflib marker writeINI sets, like any file it wrote
+    const QString path = dir.filePath("zdl.ini");
+    const QByteArray original =
+            "[zdl.general]\n"
+            "conflib=sunrise\n"
+            "\n"
+            "[zdl.save]\n"
+            "file0=/doom/wads/first.wad\n"
+            "file1d=/doom/wads/second.pk3\n"
+            "warp=MAP01\n"
+            "\n"
+            "[zdl.ports]\n"
+            "p0n=GZDoom\n"
+            "p0f=/usr/games/gzdoom\n";
+    if (!writeFile(path, original)) {
+        qCritical() << "Cannot write" << path;
+        return 1;
+    }
+
+    //Normalise the layout once, so that later writes compare equal
+    {
+        ZDLConf zconf;
+        zconf.readINI(path);
+        zconf.setValue("zdl.save", "skill", "3");
+        check(zconf.writeINI(path) == 0, "first write");
+    }
+    const QByteArray saved = contents(path);
+
+    check(!rewrites(path, [](ZDLConf &) {}), "unchanged read then write leaves the file alone");
+    check(contents(path) == saved, "an unchanged write keeps the contents");
+
+    check(!rewrites(path, [](ZDLConf &zconf) { zconf.setValue("zdl.save", "warp", "MAP01"); }),
+          "setting a value to what it already is leaves the file alone");
+
+    check(rewrites(path, [](ZDLConf &zconf) { zconf.setValue("zdl.save", "warp", "MAP07"); }),
+          "setValue rewrites the file");
+    check(rewrites(path, [](ZDLConf &zconf) { zconf.deleteSection("zdl.ports"); }),
+          "deleteSection rewrites the file");
+    check(rewrites(path, [](ZDLConf &zconf) { zconf.deleteRegex("zdl.save", "^file[0-9]+d?$"); }),
+          "a change made inside a section rewrites the file");
+
+    {
+        ZDLConf zconf;
+        zconf.readINI(path);
+        check(zconf.getValue("zdl.save", "warp") == "MAP07", "the new value is read back");
+        check(!zconf.getSection("zdl.ports"), "the deleted section stays deleted");
+        check(!zconf.hasValue("zdl.save", "file0"), "the deleted lines stay deleted");
+        check(zconf.getValue("zdl.save", "skill") == "3", "the other lines are kept");
+    }
+
+    //A configuration that held something before the read doesn't match the file
+    {
+        ZDLConf zconf;
+        zconf.setValue("zdl.save", "skill", "3");
+        zconf.readINI(path);
+        backdate(path);
+        check(zconf.writeINI(path) == 0, "writing a merged configuration");
+        check(rewritten(path), "a configuration that wasn't empty before reading is written");
+    }
+
+    //The file must still be there to skip writing it
+    {
+        ZDLConf zconf;
+        zconf.readINI(path);
+        QByteArray before = contents(path);
+        QFile::remove(path);
+        check(zconf.writeINI(path) == 0, "writing a removed file");
+        check(contents(path) == before, "a removed file is written again");
+    }
+
+    //A second write of the same configuration is skipped as well
+    {
+        ZDLConf zconf;
+        zconf.readINI(path);
+        zconf.setValue("zdl.save", "warp", "E1M1");
+        check(zconf.writeINI(path) == 0, "writing a change");
+        backdate(path);
+        check(zconf.writeINI(path) == 0, "writing it again");
+        check(!rewritten(path), "writing the same configuration twice only writes once");
+    }
+
+    //Writing to another file always writes, and gives the same text back
+    {
+        const QString copy_path = dir.filePath("copy.ini");
+        ZDLConf zconf;
+        zconf.readINI(path);
+        check(zconf.writeINI(copy_path) == 0, "writing a copy");
+        check(contents(copy_path) == contents(path), "the file round-trips");
+
+        ZDLConf reread;
+        reread.readINI(copy_path);
+        check(reread.getValue("zdl.save", "warp") == "E1M1", "the copy reads back");
+    }
+
+    //QSaveFile renamed its temporary files over the targets
+    QStringList files = QDir(dir.path()).entryList(QDir::Files);
+    check(files == QStringList({"copy.ini", "zdl.ini"}), "no temporary files are left behind");
+
+    return failed ? 1 : 0;
+}